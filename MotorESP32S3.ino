@@ -31,6 +31,12 @@
 #include <esp_task_wdt.h>
 // Include mDNS for local network name resolution (e.g., esp32.local).
 #include <ESPmDNS.h>
+// Include atomics for the lock-free LED edge rings shared with the GPIO interrupts.
+#include <atomic>
+// Include the binary frame format shared with the HMI firmware (usf/bin/... topics).
+#include "usf_wire.h"
+
+#include "usf_metrics.h"
 
 // ===== Login Configuration =====
 // Set the username and password for the local web server login.
@@ -52,17 +58,20 @@ const char* mqttTopic = "usf/messages";
 const char* generalLogTopic = "usf/logs/general";
 const char* commandLogTopic = "usf/logs/command";
 const char* alertLogTopic = "usf/logs/alerts";
+const char* emailAlertTopic = "usf/alerts/email";
+const char* binStatusTopic = USF_BIN_STATUS_TOPIC;   // Binary state frames for the HMI
+const char* binCommandTopic = USF_BIN_COMMAND_TOPIC; // Binary command frames from the HMI
 
 // --- Function Prototypes ---
 // Declare functions before they are used in the code.
 void addToLog(const String &message);
 void flushLogBuffer();
-void publishMessage(const String& message);
-void publishGeneralLog(const String& msg, const char* type);
-void publishCommandLog(const String& msg);
-void publishAlert(const char* level, const String& msg);
+void publishMessage(const char* message);
+void publishGeneralLog(const char* msg, const char* type);
+void publishCommandLog(const char* msg);
+void publishAlert(const char* level, const char* msg);
 void callback(char* topic, byte* payload, unsigned int length);
-void processLEDStatus(const String& tempStatus, unsigned long currentMillis);
+void processLEDStatus(const char* tempStatus, uint16_t pattern);
 
 // EMQX Root CA Certificate
 // This certificate is used to verify the identity of the MQTT broker for secure (TLS) connections.
@@ -105,8 +114,8 @@ typedef struct struct_message {
 
 struct_message incomingDataStruct;
 
-unsigned long lastHealthCheck = 0;
-const unsigned long HEALTH_CHECK_INTERVAL = 300000; // Changed to 5 minutes (300000ms)
+unsigned long lastHealthCheck = 0; // Last usf/metrics publish
+const unsigned long HEALTH_CHECK_INTERVAL = 60000; // usf/metrics publish period
 // Timing Configuration (ms)
 unsigned long LIFT_MODE_DELAY = 100; // Reduced from 200ms to 100ms
 unsigned long ELEVATOR_MODE_DELAY = 100; // Reduced from 200ms to 100ms
@@ -146,20 +155,13 @@ bool lastStateGreen[numLEDs] = {LOW, LOW, LOW, LOW}; // Array to store last read
 int changeCountRed[numLEDs] = {0, 0, 0, 0}; // Array to count state changes for Red LEDs
 int changeCountGreen[numLEDs] = {0, 0, 0, 0}; // Array to count state changes for Green LEDs
 
-// Global variable to hold LED status for the web UI
-String ledStatus = ""; // This string will be updated with LED status info for the webpage
-
 // ===== Global Variables ===== //
-String serialLogs; // Stored Logs on to send to the web interface
 bool elevatorMode = false; // Track the mode
 String currentDirection = "none"; // Track current movement direction
-String greenAlarms = "";  // Green alarm messages
-String amberAlarms = "";  // Amber alarm messages
-String redAlarms = "";    // Red alarm messages
+const char* greenAlarms = "";  // Green alarm code (points into alarmTable)
+const char* amberAlarms = "";  // Amber alarm code
+const char* redAlarms = "";    // Red alarm code
 unsigned long lastActionTime = 0; // Track when last action was made
-String ledStatusHistory = "";
-String lastLedSnapshot = "";
-String lastRedEmailSent = "";
 String lastAmberEmailSent = "";
 String lastGreenEmailSent = "";
 
@@ -170,18 +172,222 @@ PubSubClient mqttClient(espClient);
 const char* alarmTopic = "usf/alarms";
 const char* statusTopic = "usf/status";
 
+// Classified LED modes
+enum LEDMode : uint8_t { LED_MODE_OFF = 0, LED_MODE_ON = 1, LED_MODE_FLASHING = 2 };
+
 // LED state structure
 struct LEDState {
-    bool currentState;
-    bool lastState;
-    int changeCount;
-    unsigned long lastChange;
+    bool currentState;          // Raw pin level after the last captured edge
+    bool lastState;             // Steady ON (what the alarm decoder sees as "on")
+    int changeCount;            // Edges captured since boot
+    unsigned long lastChange;   // micros() of the last captured edge
+    LEDMode mode;               // Classified OFF / ON / FLASHING
+    unsigned long flashPeriod;  // Measured flash period in ms while FLASHING
+    unsigned long lastInterval; // Previous in-window edge interval (us)
+    uint8_t flashEdges;         // Consecutive edges spaced like a flash
 };
 
 // LED states arrays
 LEDState redLEDStates[4];
 LEDState greenLEDStates[4];
 
+// ===== LED Edge Capture =====
+// Every edge on an LED input is timestamped by a GPIO interrupt into a per-pin
+// single-producer/single-consumer ring, so flashes are measured from real edge
+// intervals and survive loop() stalls (e.g. reconnectMQTT()).
+#define LED_EDGE_RING_SIZE 64                  // Power of two; ~12 s of edges at a 2.5 Hz flash
+#define LED_EDGE_RING_MASK (LED_EDGE_RING_SIZE - 1)
+const unsigned long LED_GLITCH_US = 20000;     // Edges closer than 20 ms are contact noise
+const unsigned long LED_FLASH_MAX_HALF_US = 1500000; // Longer than 1.5 s without an edge = steady
+const uint8_t LED_FLASH_MIN_EDGES = 3;         // Edges (one full period) before calling it FLASHING
+
+struct LEDEdgeRing {
+    uint8_t pin;
+    std::atomic<uint32_t> head;                // Written by the ISR only
+    std::atomic<uint32_t> tail;                // Written by the consumer only
+    uint32_t time[LED_EDGE_RING_SIZE];         // micros() of each edge
+    uint8_t level[LED_EDGE_RING_SIZE];         // Pin level right after the edge
+    std::atomic<uint32_t> overflows;           // Edges dropped because the ring was full
+};
+
+LEDEdgeRing redEdgeRings[4];
+LEDEdgeRing greenEdgeRings[4];
+
+// ===== Alarm Decoder =====
+// The 4 red + 4 green LEDs are packed into one 16-bit pattern so an alarm lookup
+// is a handful of table reads instead of the old if/else chains:
+//   bits 0-3   red LED n steady ON        bits 8-11  red LED n FLASHING
+//   bits 4-7   green LED n steady ON      bits 12-15 green LED n FLASHING
+#define LED_RED_SHIFT         0
+#define LED_GREEN_SHIFT       4
+#define LED_RED_FLASH_SHIFT   8
+#define LED_GREEN_FLASH_SHIFT 12
+
+// Interlock actions required by an alarm
+#define ALARM_ACTION_STOP_UP   0x01
+#define ALARM_ACTION_STOP_DOWN 0x02
+#define ALARM_ACTION_EMAIL     0x04
+#define ALARM_ACTION_STOP_BOTH (ALARM_ACTION_STOP_UP | ALARM_ACTION_STOP_DOWN)
+
+enum AlarmCode : uint8_t {
+    ALARM_NONE = 0,
+    // Red alarms
+    ALARM_R01, ALARM_R02, ALARM_R15, ALARM_R23, ALARM_R22, ALARM_R00, ALARM_R31,
+    ALARM_R36, ALARM_R37, ALARM_R07, ALARM_R03, ALARM_R27, ALARM_R10, ALARM_R11,
+    ALARM_R12, ALARM_R13, ALARM_R24, ALARM_R05,
+    // Green alarms
+    ALARM_G01, ALARM_G00, ALARM_G02, ALARM_G03, ALARM_G04,
+    // Amber alarms
+    ALARM_A01, ALARM_A04, ALARM_A39, ALARM_A30, ALARM_A33, ALARM_A34, ALARM_A35,
+    ALARM_A36, ALARM_A37, ALARM_A02, ALARM_A32, ALARM_A40, ALARM_A06, ALARM_A08,
+    ALARM_A14, ALARM_A16, ALARM_A38,
+    ALARM_CODE_COUNT
+};
+
+struct AlarmInfo {
+    const char* code;         // Code shown in logs and on the web UI
+    const char* description;  // Human readable description
+    const char* emailMessage; // Custom email text (NULL = "<code> - <description>")
+    uint8_t actions;          // ALARM_ACTION_* flags
+};
+
+// Indexed by AlarmCode
+const AlarmInfo alarmTable[ALARM_CODE_COUNT] = {
+    {"",    "Unknown Alert Code",                    NULL, 0},
+    {"R01", "All RED LEDs are OFF",                  NULL, ALARM_ACTION_EMAIL},
+    {"R02", "E-Stop is OFF",                         NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R15", "OSG/Pit Switch activated",              NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R23", "Door Lock Failure",                     NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R22", "Door Open",                             NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R00", "No FLASHING RED LEDs",                  NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R31", "Out of Service (flood switch)",         NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R36", "Out of Service – periodic maintenance", NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R37", "Out of Service (travel time)",          NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R07", "Drive Train, Belt Failure",             NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R03", "Drive Nut Friction block fails",        NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R27", "Drive Train Alignment",                 NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R10", "Final Limit", "Final Limit (R10) - Lift has reached final limit switch",
+                                                           ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R11", "Landing Switch (Top) failure",          NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R12", "Landing Switch (Mid) failure",          NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R13", "Landing Switch (Bottom) failure",       NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R24", "Drive Train Motor Failure",             NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"R05", "Motor temperature failure",             NULL, ALARM_ACTION_STOP_BOTH | ALARM_ACTION_EMAIL},
+    {"G01", "All GREEN LEDs are OFF",                NULL, 0},
+    {"G00", "No exceptions",                         NULL, 0},
+    {"G02", "No FLASHING GREEN LEDs",                NULL, 0},
+    {"G03", "On Battery Power",                      NULL, 0},
+    {"G04", "Bypass Jumpers/Service Switch",         NULL, 0},
+    {"A01", "ALL AMBER LEDs OFF",                    NULL, 0},
+    {"A04", "Power Failure",                         NULL, 0},
+    {"A39", "Power Failure",                         NULL, 0},
+    {"A30", "Service Required (Flood switch)",       NULL, 0},
+    {"A33", "Service Required – travel time",        NULL, 0},
+    {"A34", "Service Required – maintenance",        NULL, 0},
+    {"A35", "Service Required – hours",              NULL, 0},
+    {"A36", "Service Required – Battery",            NULL, 0},
+    {"A37", "Service Required - Inverter",           NULL, 0},
+    {"A02", "No FLASHING AMBER LEDs",                NULL, 0},
+    {"A32", "Power Failure - UP Locked",             NULL, ALARM_ACTION_STOP_UP},
+    {"A40", "Power Failure",                         NULL, 0},
+    {"A06", "Motor Failure - UP Locked",             NULL, ALARM_ACTION_STOP_UP},
+    {"A08", "Anti-Rock binding - UP Locked",         NULL, ALARM_ACTION_STOP_UP},
+    {"A14", "Bottom Final Limit - DOWN Locked",      NULL, ALARM_ACTION_STOP_DOWN},
+    {"A16", "Flood waters - DOWN Locked",            NULL, ALARM_ACTION_STOP_DOWN},
+    {"A38", "Motor Temperature monitoring lost",     NULL, 0},
+};
+
+// Per-colour nibble lookups (index bit n = LED n). A flashing match always
+// overrides the steady match, exactly as the old chains did.
+const AlarmCode redSteadyAlarms[16] = {
+    ALARM_R01,  ALARM_NONE, ALARM_NONE, ALARM_R23,  // 0000 0001 0010 0011
+    ALARM_NONE, ALARM_NONE, ALARM_NONE, ALARM_R15,  // 0100 0101 0110 0111
+    ALARM_NONE, ALARM_NONE, ALARM_NONE, ALARM_NONE, // 1000 1001 1010 1011
+    ALARM_R22,  ALARM_NONE, ALARM_NONE, ALARM_R02   // 1100 1101 1110 1111
+};
+const AlarmCode redFlashAlarms[16] = {
+    ALARM_R00,  ALARM_R37,  ALARM_R31,  ALARM_NONE,
+    ALARM_R11,  ALARM_R13,  ALARM_R12,  ALARM_R10,
+    ALARM_R05,  ALARM_R27,  ALARM_R07,  ALARM_NONE,
+    ALARM_R24,  ALARM_NONE, ALARM_R36,  ALARM_R03
+};
+const AlarmCode greenSteadyAlarms[16] = {
+    ALARM_G01,  ALARM_NONE, ALARM_NONE, ALARM_NONE,
+    ALARM_NONE, ALARM_NONE, ALARM_NONE, ALARM_NONE,
+    ALARM_NONE, ALARM_NONE, ALARM_NONE, ALARM_NONE,
+    ALARM_NONE, ALARM_NONE, ALARM_NONE, ALARM_G00
+};
+const AlarmCode greenFlashAlarms[16] = {
+    ALARM_G02,  ALARM_NONE, ALARM_NONE, ALARM_NONE,
+    ALARM_NONE, ALARM_NONE, ALARM_NONE, ALARM_G03,
+    ALARM_NONE, ALARM_NONE, ALARM_NONE, ALARM_NONE,
+    ALARM_NONE, ALARM_NONE, ALARM_NONE, ALARM_G04
+};
+const AlarmCode amberSteadyAlarms[16] = {
+    ALARM_A01,  ALARM_A30,  ALARM_A33,  ALARM_A34,
+    ALARM_A35,  ALARM_NONE, ALARM_NONE, ALARM_A04,
+    ALARM_NONE, ALARM_A37,  ALARM_NONE, ALARM_NONE,
+    ALARM_A36,  ALARM_NONE, ALARM_A39,  ALARM_NONE
+};
+const AlarmCode amberFlashAlarms[16] = {
+    ALARM_A02,  ALARM_NONE, ALARM_A16,  ALARM_A14,
+    ALARM_A06,  ALARM_NONE, ALARM_A38,  ALARM_A32,
+    ALARM_NONE, ALARM_A08,  ALARM_NONE, ALARM_NONE,
+    ALARM_NONE, ALARM_NONE, ALARM_A40,  ALARM_NONE
+};
+
+// Result of decoding one LED pattern
+struct AlarmDecode {
+    AlarmCode red;
+    AlarmCode green;
+    AlarmCode amber;
+    uint8_t actions; // ALARM_ACTION_* flags of all three alarms combined
+};
+
+// Alarm colour bits (event log filters)
+#define ALARM_COLOUR_RED   0x01
+#define ALARM_COLOUR_GREEN 0x02
+#define ALARM_COLOUR_AMBER 0x04
+
+// ===== Event Log =====
+// Fixed-size binary records in a circular SPIFFS file. Record seq lives in slot
+// (seq - 1) % EVENT_LOG_CAPACITY, so the file only grows at its end until it wraps.
+// New records are batched in RAM and written in runs.
+// The only RAM index is one colour bitmask per page of records, so colour
+// filtered queries can skip whole pages without reading them.
+#define EVENT_LOG_FILE "/events.bin"
+#define EVENT_LOG_CAPACITY 32768             // Records kept in flash (512 KB)
+#define EVENT_LOG_PAGE_SIZE 256              // Records per index page
+#define EVENT_LOG_PAGES (EVENT_LOG_CAPACITY / EVENT_LOG_PAGE_SIZE)
+#define EVENT_LOG_PENDING_SIZE 32            // Records buffered in RAM between flash writes
+#define EVENT_LOG_FLUSH_INTERVAL 5000        // Flush pending records at least every 5 s
+#define EVENT_QUERY_DEFAULT_LIMIT 50
+#define EVENT_QUERY_MAX_LIMIT 200
+
+enum EventType : uint8_t {
+    EVENT_BOOT = 1,       // Firmware started
+    EVENT_LED_CHANGE = 2, // Classified LED pattern changed
+    EVENT_ALARM = 3       // A red/green/amber alarm became active
+};
+
+struct EventRecord {
+    uint32_t seq;         // Sequence number, starts at 1 (0 = empty slot)
+    uint32_t timestamp;   // Unix time in seconds, 0 if the clock was not synced
+    uint32_t uptime;      // millis() when logged
+    uint16_t ledPattern;  // LED_*_SHIFT bitmask
+    uint8_t type;         // EventType
+    uint8_t alarm;        // AlarmCode, ALARM_NONE unless type == EVENT_ALARM
+};
+static_assert(sizeof(EventRecord) == 16, "EventRecord must stay 16 bytes on flash");
+
+uint32_t eventLogNewestSeq = 0;                       // Last sequence number assigned
+uint32_t eventLogFlushedSeq = 0;                      // Last sequence number written to flash
+EventRecord eventLogPending[EVENT_LOG_PENDING_SIZE];  // eventLogFlushedSeq+1 .. eventLogNewestSeq
+uint8_t eventLogPageColours[EVENT_LOG_PAGES];         // ALARM_COLOUR_* present in each page
+uint8_t eventLogWritePageColours = 0;                 // Colours written to the current page this lap
+unsigned long eventLogLastFlush = 0;
+uint32_t eventLogDropped = 0;                         // Records lost because flash refused the writes
+
 // Alert system configuration
 #define ALERT_COOLDOWN 5000        // 5 seconds between different alerts
 #define ALERT_DEBOUNCE_TIME 1000   // 1 second debounce for state changes
@@ -189,7 +395,7 @@ LEDState greenLEDStates[4];
 
 // Alert tracking structure
 struct AlertState {
-    String message;
+    AlarmCode code;
     unsigned long lastChangeTime;
     unsigned long lastPublishTime;
     bool isActive;
@@ -201,152 +407,670 @@ AlertState redAlertState;
 AlertState amberAlertState;
 AlertState greenAlertState;
 
+// Alarms decoded from the latest LED pattern
+AlarmDecode activeAlarms = {ALARM_NONE, ALARM_NONE, ALARM_NONE, 0};
+
+// Last red alarm an email was sent for
+AlarmCode lastRedEmailSent = ALARM_NONE;
+
 // Global variables for alarm states
 String currentRedAlarms = "";
 String currentGreenAlarms = "";
 String currentAmberAlarms = "";
 
+// ===== MQTT Publish Queue =====
+// Publishes are queued as fixed-size entries and sent in batches by
+// drainPublishQueue(). When the RAM queue is full (typically because the broker
+// is unreachable) the oldest entries spill to a SPIFFS segment file; spilled
+// entries are always older than the RAM queue and are replayed first.
+#define MQTT_PAYLOAD_SIZE 256
+#define PUBLISH_QUEUE_SIZE 16
+#define PUBLISH_BATCH_SIZE 4                   // Entries sent per drain step
+#define PUBLISH_SPILL_FILE "/mqtt_spill.bin"
+#define PUBLISH_SPILL_MAX_SIZE (64 * 1024)     // Bytes of spilled entries kept in flash
+#define PUBLISH_SPILL_ALERT_RESERVE (16 * 1024) // Extra room only alerts/emails may use
+
+// Topic bits: one entry can go to several topics with the same payload
+#define TOPIC_MESSAGES    0x01
+#define TOPIC_GENERAL_LOG 0x02
+#define TOPIC_COMMAND_LOG 0x04
+#define TOPIC_ALERT_LOG   0x08
+#define TOPIC_EMAIL_ALERT 0x10
+#define TOPIC_BIN_STATUS  0x20
+const char* const publishTopics[] = {mqttTopic, generalLogTopic, commandLogTopic, alertLogTopic, emailAlertTopic, binStatusTopic};
+const int numPublishTopics = sizeof(publishTopics) / sizeof(publishTopics[0]);
+
+struct PublishEntry {
+    uint8_t topics;    // TOPIC_* bits still to be sent
+    uint16_t length;
+    char payload[MQTT_PAYLOAD_SIZE];
+};
+
+PublishEntry publishQueue[PUBLISH_QUEUE_SIZE];
+size_t publishQueueHead = 0;      // Index of the oldest entry
+size_t publishQueueCount = 0;
+PublishEntry spillEntry;          // Spilled entry currently being replayed
+bool spillEntryLoaded = false;
+size_t spillReadOffset = 0;       // Replay position in PUBLISH_SPILL_FILE
+bool spillPending = false;        // PUBLISH_SPILL_FILE has entries left to replay
+unsigned long publishDropped = 0; // Entries lost because flash was full or unavailable
+uint32_t statusFrameSeq = 0;      // Sequence number of the last usf_frame_t sent
+
+// ===== Status Streaming =====
+// /getStatus and /stream share one cursor, "<event seq>-<log bytes>-<config revision>".
+// It is also the ETag: a client holding the current cursor gets a 304, and a client
+// that passes an older one back (?since= or Last-Event-ID) only gets what changed.
+#define STATUS_JSON_BUFFER_SIZE 8192
+#define STATUS_DELTA_MAX_EVENTS 16      // Event records per delta; the rest follow in the next one
+#define STREAM_MAX_CLIENTS 4
+#define STREAM_PUSH_INTERVAL 250        // Check for changes to push every 250 ms
+#define STREAM_KEEPALIVE_INTERVAL 15000 // Comment line so proxies keep idle streams open
+
+struct StatusCursor {
+    uint32_t eventSeq;   // Newest event record reported
+    uint32_t logBytes;   // serialLogsTotal reported
+    uint32_t configRev;  // configRevision reported
+};
+
+struct StreamClient {
+    WiFiClient client;
+    StatusCursor cursor;
+    unsigned long lastSend;
+    bool active;
+};
+
+StreamClient streamClients[STREAM_MAX_CLIENTS];
+unsigned long lastStreamPush = 0;
+uint32_t configRevision = 0;              // Bumped when the email settings change
+char statusJson[STATUS_JSON_BUFFER_SIZE]; // Shared by /getStatus, /stream and /metrics (all run on the loop task)
+
+// ===== Hardware Abstraction =====
+// Every time read, and every pin the control logic (LED capture, buttons, relays,
+// output commands) touches, goes through these. A simulation build defines MOTOR_HAL_EXTERNAL and
+// links its own versions (virtual clock, simulated GPIO that calls the edge ISR).
+#ifndef MOTOR_HAL_EXTERNAL
+// Macros rather than functions: no call in the IRAM ISR and no generated prototypes
+#define halMillis() millis()
+#define halMicros() micros()
+#define halDigitalRead(pin) digitalRead(pin)
+#define halDigitalWrite(pin, level) digitalWrite(pin, level)
+#define halPinMode(pin, mode) pinMode(pin, mode)
+#define halAttachEdgeInterrupt(pin, isr, arg) attachInterruptArg(digitalPinToInterrupt(pin), isr, arg, CHANGE)
+#else
+unsigned long halMillis();
+unsigned long halMicros();
+int halDigitalRead(uint8_t pin);
+void halDigitalWrite(uint8_t pin, uint8_t level);
+void halPinMode(uint8_t pin, uint8_t mode);
+void halAttachEdgeInterrupt(uint8_t pin, void (*isr)(void*), void* arg);
+#endif
+
+// ===== I/O Task =====
+// Button debounce, LED scan, alarm interlocks and relay/output control run in
+// ioTask(), a fixed-rate task. WiFi, MQTT, TLS, the web server and logging stay
+// on the Arduino loop. The two sides only exchange the lock-free rings below,
+// so a broker outage or a blocking reconnect can never delay a stop.
+// ioTask shares core 1 with the loop, above the loop's priority, so it preempts
+// a blocking connect. Core 0 is left to the WiFi driver and lwIP, whose bursts
+// the I/O task then never waits behind. This choice has not been measured on a
+// board yet: build with IO_JITTER_TEST on both cores and compare the reports.
+#define IO_TASK_CORE ARDUINO_RUNNING_CORE // Core 1, with loopTask (priority 1)
+#define IO_TASK_PRIORITY (configMAX_PRIORITIES - 1)
+#define IO_TASK_STACK_SIZE 4096
+#define IO_TASK_PERIOD_MS 5
+#define IO_QUEUE_SIZE 32                  // Power of two
+#define IO_QUEUE_MASK (IO_QUEUE_SIZE - 1)
+#define OUTPUT_DEADTIME_MS 10             // Both remote outputs LOW for this long when reversing
+
+// Jitter measurement mode: a load task floods the network from the I/O task's core,
+// as the loop's network calls do, every other phase. The I/O period deviation of
+// idle and loaded phases is reported to Serial and the general log
+#define IO_JITTER_TEST 0
+#define IO_JITTER_PHASE_MS 10000          // Idle and network load phases alternate, one report each
+#define IO_JITTER_LATE_US 1000            // Periods off by more than this count as late
+#define IO_JITTER_LOAD_PRIORITY 1         // Load task on IO_TASK_CORE at loopTask's priority
+#define IO_JITTER_LOAD_STACK_SIZE 8192    // TLS connect
+#define IO_JITTER_UDP_PORT 9              // Discard service on the gateway
+#define IO_JITTER_UDP_BURST_MS 500        // UDP flood between two TLS connects
+#define IO_JITTER_BLACKHOLE "10.255.255.1" // Unroutable, so the TLS connect waits out its timeout
+#define IO_JITTER_TLS_PORT 8883
+#define IO_JITTER_TLS_TIMEOUT_MS 2000
+
+enum IoCommandType : uint8_t {
+    IO_CMD_OUTPUT = 1,  // Remote output pins, arg = USF_CMD_* (| IO_OUTPUT_ECHO)
+    IO_CMD_MOVE,        // Motor relays, arg = USF_DIR_* (USF_DIR_STOP releases both)
+    IO_CMD_STOP_UP,     // Release the UP relay only
+    IO_CMD_STOP_DOWN,   // Release the DOWN relay only
+    IO_CMD_BRAKE        // arg = 1 apply, 0 release
+};
+
+enum IoEventType : uint8_t {
+    IO_EVT_MOVE = 1,    // Relays driven by a button or command, arg = USF_DIR_*
+    IO_EVT_HALT,        // One moving direction released, arg = USF_DIR_UP / USF_DIR_DOWN
+    IO_EVT_BRAKE,       // arg = 1 applied, 0 released
+    IO_EVT_OUTPUT,      // Remote output pins set, arg = USF_CMD_* (| IO_OUTPUT_ECHO)
+    IO_EVT_LED,         // LED pattern changed
+    IO_EVT_LOCKED       // Movement refused by an alarm interlock, arg = USF_DIR_*
+};
+
+#define IO_OUTPUT_ECHO 0x80 // IO_CMD_OUTPUT / IO_EVT_OUTPUT arg bit: echo "Command executed" once carried out
+
+// Events that carry pin state the loop mirrors (currentDirection, logs, status
+// frames). One refused by a full ring is kept and retried, so it is never lost.
+enum IoStateSlot : uint8_t {
+    IO_SLOT_DIRECTION,  // IO_EVT_MOVE / IO_EVT_HALT
+    IO_SLOT_BRAKE,
+    IO_SLOT_OUTPUT,
+    IO_SLOT_COUNT
+};
+
+struct IoCommand {
+    uint8_t type;       // IO_CMD_*
+    uint8_t arg;
+    uint32_t receivedUs; // halMicros() when the command arrived (command latency metric)
+};
+
+struct IoEvent {
+    uint8_t type;                       // IO_EVT_*
+    uint8_t arg;
+    uint16_t ledPattern;                // IO_EVT_LED: getLEDPattern()
+    uint16_t flashPeriod[2 * numLEDs];  // IO_EVT_LED: red 0-3 then green 0-3, ms
+};
+
+// Ring between exactly one producer and one consumer task (same scheme as LEDEdgeRing)
+template <typename T>
+struct IoQueue {
+    std::atomic<uint32_t> head;         // Written by the producer only
+    std::atomic<uint32_t> tail;         // Written by the consumer only
+    std::atomic<uint32_t> full;         // Pushes refused because the ring was full
+    T items[IO_QUEUE_SIZE];
+
+    bool push(const T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= IO_QUEUE_SIZE) {
+            full.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items[h & IO_QUEUE_MASK] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        item = items[t & IO_QUEUE_MASK];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+IoQueue<IoCommand> ioCommands;      // Loop (MQTT callback) -> I/O task
+IoQueue<IoCommand> espNowCommands;  // WiFi task (ESP-NOW receive) -> I/O task
+IoQueue<IoEvent> ioEvents;          // I/O task -> loop
+TaskHandle_t ioTaskHandle = NULL;
+
+// Owned by the I/O task
+uint8_t ioDirection = USF_DIR_STOP;      // Motor relays
+uint8_t ioOutput = USF_CMD_STOP;         // Remote output pin driven HIGH (USF_CMD_STOP = none)
+uint8_t ioPendingOutput = USF_CMD_NONE;  // Output waiting for OUTPUT_DEADTIME_MS
+unsigned long ioOutputReleasedAt = 0;    // halMillis() when an output last went LOW
+uint32_t ioPendingReceivedUs = 0;        // receivedUs of the command behind ioPendingOutput
+bool ioPendingEcho = false;              // ioPendingOutput came as a binary frame (IO_OUTPUT_ECHO)
+uint16_t ioLEDPattern = 0;               // Pattern the interlocks were last applied for
+uint8_t ioLockout = 0;                   // ALARM_ACTION_STOP_* required by ioLEDPattern
+bool ioLEDReported = false;              // ioLEDPattern has been posted to the loop
+IoEvent ioUnreported[IO_SLOT_COUNT];     // Newest direction/brake/output event the full ring refused
+uint8_t ioUnreportedMask = 0;            // Bit per IO_SLOT_* waiting in ioUnreported
+uint64_t ioPinsHigh = 0;                 // Output pins driven HIGH, one bit per GPIO
+uint32_t ioPinChanges = 0;               // ioWritePin() calls that changed a level
+
+// Written by the I/O task, read and reset by the loop
+std::atomic<uint32_t> ioJitterMaxUs;     // Largest period deviation
+std::atomic<uint32_t> ioJitterSumUs;
+std::atomic<uint32_t> ioJitterCycles;
+std::atomic<uint32_t> ioJitterLate;      // Periods off by more than IO_JITTER_LATE_US
+
+// Jitter test load task (IO_JITTER_TEST)
+std::atomic<bool> ioJitterLoad;          // Set by the loop during a load phase
+std::atomic<bool> ioJitterLoadRunning;   // Load task mid-burst or mid-connect
+std::atomic<uint32_t> ioJitterUdpPackets;
+std::atomic<uint32_t> ioJitterTlsConnects;
+
+// Owned by the loop
+uint16_t reportedLEDPattern = 0;         // Newest pattern reported by the I/O task
+
+// ===== Metrics =====
+// Hot-path latency histograms (usf_metrics.h) plus heap, stack and connection
+// counters, served as Prometheus text on /metrics and published as compact JSON
+// on USF_METRICS_TOPIC every HEALTH_CHECK_INTERVAL.
+#define METRICS_PAYLOAD_SIZE 320  // Compact usf/metrics JSON (sent directly, not queued)
+
+usf_hist_t loopHist;      // loop() iteration (loop)
+usf_hist_t ledScanHist;   // readDeviceOutputs() (I/O task)
+usf_hist_t ledStatusHist; // processLEDStatus() (loop)
+usf_hist_t publishHist;   // One mqttClient.publish() (loop)
+usf_hist_t commandHist;   // Command received -> pin set (I/O task)
+
+struct MetricHistogram {
+    const char* name;      // Prometheus name, in seconds
+    const char* help;
+    const char* shortName; // Key in the usf/metrics payload
+    usf_hist_t* hist;
+};
+
+const MetricHistogram metricHistograms[] = {
+    {"usf_loop_duration_seconds", "Arduino loop() iteration time", "loop", &loopHist},
+    {"usf_led_scan_duration_seconds", "readDeviceOutputs() time in the I/O task", "scan", &ledScanHist},
+    {"usf_led_status_duration_seconds", "processLEDStatus() time", "led", &ledStatusHist},
+    {"usf_mqtt_publish_duration_seconds", "Time of one MQTT publish", "pub", &publishHist},
+    {"usf_command_latency_seconds", "Command received to output pin set", "cmd", &commandHist},
+};
+const int numMetricHistograms = sizeof(metricHistograms) / sizeof(metricHistograms[0]);
+usf_hist_t metricsPublished[numMetricHistograms]; // Histograms at the last usf/metrics publish
+
+uint32_t wifiReconnects = 0;      // WiFi.begin() retries after a lost connection
+uint32_t mqttConnects = 0;        // Successful broker connections
+uint32_t mqttConnectFailures = 0;
+
 // Function declarations
 void stopUpMovement();
 void stopDownMovement();
 void stopMovement();
-void handleMovement(const char* direction);
+void handleMovement(uint8_t direction);
 void applyBrake();
 void releaseBrake();
+void ioWritePin(uint8_t pin, uint8_t level);
+
+// Get timestamp function: formats at most once per second and returns the cached text
+const char* getTimestamp() {
+  static char cachedTimestamp[32] = "";
+  static unsigned long cachedSecond = 0;
+  unsigned long second = halMillis() / 1000;
+  if (cachedTimestamp[0] == '\0' || second != cachedSecond) {
+    struct tm timeinfo;
+    if (getLocalTime(&timeinfo, 0)) {
+      strftime(cachedTimestamp, sizeof(cachedTimestamp), "%Y-%m-%d %H:%M:%S", &timeinfo);
+    } else {
+      strcpy(cachedTimestamp, "Failed to obtain time");
+    }
+    cachedSecond = second;
+  }
+  return cachedTimestamp;
+}
 
-// Get timestamp function
-String getTimestamp() {
-  struct tm timeinfo;
-  if(!getLocalTime(&timeinfo)){
-    return "Failed to obtain time";
+// Drive an output pin from the I/O task, counting the writes that change its level
+void ioWritePin(uint8_t pin, uint8_t level) {
+  uint64_t bit = 1ULL << pin;
+  if (((ioPinsHigh & bit) != 0) != (level == HIGH)) {
+    ioPinsHigh ^= bit;
+    ioPinChanges++;
   }
-  char timeStringBuff[50];
-  strftime(timeStringBuff, sizeof(timeStringBuff), "%Y-%m-%d %H:%M:%S", &timeinfo);
-  return String(timeStringBuff);
+  halDigitalWrite(pin, level);
 }
 
-// Movement control functions
+// Movement control functions (I/O task only): drive the relays, the loop logs them
 void stopUpMovement() {
-  digitalWrite(UP_PIN, LOW);
-  if (currentDirection == "up") {
-    currentDirection = "none";
-    addToLog("Stopped upward movement");
+  ioWritePin(UP_PIN, LOW);
+  if (ioDirection == USF_DIR_UP) {
+    ioDirection = USF_DIR_STOP;
+    postIoEvent(IO_EVT_HALT, USF_DIR_UP);
   }
 }
 
 void stopDownMovement() {
-  digitalWrite(DOWN_PIN, LOW);
-  if (currentDirection == "down") {
-    currentDirection = "none";
-    addToLog("Stopped downward movement");
+  ioWritePin(DOWN_PIN, LOW);
+  if (ioDirection == USF_DIR_DOWN) {
+    ioDirection = USF_DIR_STOP;
+    postIoEvent(IO_EVT_HALT, USF_DIR_DOWN);
   }
 }
 
 void stopMovement() {
-  // Add prominent Serial output for stop command
-  Serial.println("\n=== LIFT COMMAND RECEIVED ===");
-  Serial.println("Direction: STOP");
-  Serial.println("===========================\n");
-  
-  digitalWrite(UP_PIN, LOW);
-  digitalWrite(DOWN_PIN, LOW);
-  currentDirection = "stop";
-  addToLog("Movement stopped");
-  publishCommandLog("Command executed: STOP");
-  publishGeneralLog("Movement stopped", "info");
+  ioWritePin(UP_PIN, LOW);
+  ioWritePin(DOWN_PIN, LOW);
+  ioDirection = USF_DIR_STOP;
+  postIoEvent(IO_EVT_MOVE, USF_DIR_STOP);
 }
 
-void handleMovement(const char* direction) {
-  String dir = String(direction);
-  
-  // Add prominent Serial output for lift commands
-  Serial.println("\n=== LIFT COMMAND RECEIVED ===");
-  Serial.print("Direction: ");
-  Serial.println(dir);  // Print direction as is, Arduino String class handles uppercase automatically
-  Serial.println("===========================\n");
-  
-  if (dir == "up") {
-    digitalWrite(DOWN_PIN, LOW);
-    digitalWrite(UP_PIN, HIGH);
-    currentDirection = "up";
-    addToLog("Moving up");
-    publishCommandLog("Command executed: UP");
-    publishGeneralLog("Moving up", "info");
-  } else if (dir == "down") {
-    digitalWrite(UP_PIN, LOW);
-    digitalWrite(DOWN_PIN, HIGH);
-    currentDirection = "down";
-    addToLog("Moving down");
-    publishCommandLog("Command executed: DOWN");
-    publishGeneralLog("Moving down", "info");
+void handleMovement(uint8_t direction) {
+  // An active alarm keeps its direction locked for as long as it lasts, not just when it appears
+  uint8_t lock = direction == USF_DIR_UP ? ALARM_ACTION_STOP_UP : ALARM_ACTION_STOP_DOWN;
+  if (ioLockout & lock) {
+    postIoEvent(IO_EVT_LOCKED, direction);
+    return;
   }
+  if (direction == USF_DIR_UP) {
+    ioWritePin(DOWN_PIN, LOW);
+    ioWritePin(UP_PIN, HIGH);
+  } else if (direction == USF_DIR_DOWN) {
+    ioWritePin(UP_PIN, LOW);
+    ioWritePin(DOWN_PIN, HIGH);
+  } else {
+    return;
+  }
+  ioDirection = direction;
+  postIoEvent(IO_EVT_MOVE, direction);
 }
 
 void applyBrake() {
-  digitalWrite(BRAKE_PIN, HIGH);
-  addToLog("Brake applied");
+  ioWritePin(BRAKE_PIN, HIGH);
+  postIoEvent(IO_EVT_BRAKE, 1);
 }
 
 void releaseBrake() {
-  digitalWrite(BRAKE_PIN, LOW);
-  addToLog("Brake released");
+  ioWritePin(BRAKE_PIN, LOW);
+  postIoEvent(IO_EVT_BRAKE, 0);
 }
 
-// Function to publish message via MQTT
-void publishMessage(const String& message) {
-  if (!mqttClient.connected()) return;
-  String payload = "{\"type\":\"info\",\"message\":\"" + message + "\",\"timestamp\":\"" + getTimestamp() + "\"}";
-  mqttClient.publish(mqttTopic, payload.c_str());
-  mqttClient.publish(generalLogTopic, payload.c_str()); // Also send to general log
+// ===== JSON Writer =====
+// Builds a flat JSON object in a caller-supplied buffer without touching the heap.
+// String values are escaped; if the buffer fills up the value is truncated on a
+// character boundary and the result is still a valid, NUL-terminated object.
+struct JsonWriter {
+    char* buf;
+    size_t size;     // Must be at least 3 ("{}" + NUL)
+    size_t len;
+    bool truncated;
+    bool inArray;    // Between beginArray() and endArray()
+    size_t arrayLen; // Elements in the open array
+
+    JsonWriter(char* buffer, size_t bufferSize)
+        : buf(buffer), size(bufferSize), len(0), truncated(false), inArray(false), arrayLen(0) {
+        buf[len++] = '{';
+        buf[len] = '\0';
+    }
+
+    // "key":"value"
+    void add(const char* key, const char* value) {
+        if (!openMember(key, true)) return;
+        appendEscaped(value);
+        buf[len++] = '"';
+        buf[len] = '\0';
+    }
+
+    // "key":<unsigned number>
+    void add(const char* key, unsigned long value) {
+        char digits[21]; // 64-bit unsigned long on the host build
+        snprintf(digits, sizeof(digits), "%lu", value);
+        addRaw(key, digits);
+    }
+
+    // "key":true / false
+    void add(const char* key, bool value) {
+        addRaw(key, value ? "true" : "false");
+    }
+
+    // "key":[ ... ] filled with appendElement()/appendString(); arrays do not nest
+    bool beginArray(const char* key) {
+        if (inArray || !openMember(key, false, 2)) return false;
+        buf[len++] = '[';
+        buf[len] = '\0';
+        inArray = true;
+        arrayLen = 0;
+        return true;
+    }
+
+    // Literal JSON element of the open array
+    bool appendElement(const char* raw, size_t rawLen) {
+        if (!inArray || len + (arrayLen ? 1 : 0) + rawLen + closing() > size) {
+            truncated = true;
+            return false;
+        }
+        if (arrayLen++) buf[len++] = ',';
+        memcpy(buf + len, raw, rawLen);
+        len += rawLen;
+        buf[len] = '\0';
+        return true;
+    }
+
+    // "value" element of the open array
+    bool appendString(const char* value) {
+        if (!inArray || len + (arrayLen ? 1 : 0) + 2 + closing() > size) {
+            truncated = true;
+            return false;
+        }
+        if (arrayLen++) buf[len++] = ',';
+        buf[len++] = '"';
+        appendEscaped(value);
+        buf[len++] = '"';
+        buf[len] = '\0';
+        return true;
+    }
+
+    void endArray() {
+        if (!inArray) return;
+        buf[len++] = ']';
+        buf[len] = '\0';
+        inArray = false;
+    }
+
+    // "key":<literal JSON>
+    void addRaw(const char* key, const char* raw) {
+        size_t rawLen = strlen(raw);
+        if (!openMember(key, false, rawLen)) return;
+        memcpy(buf + len, raw, rawLen);
+        len += rawLen;
+        buf[len] = '\0';
+    }
+
+    // Close the object and return the payload length
+    size_t finish() {
+        buf[len++] = '}';
+        buf[len] = '\0';
+        return len;
+    }
+
+  private:
+    // Bytes to keep free after a string body: closing quote, ']' if an array is open, '}' and NUL
+    size_t closing() const {
+        return inArray ? 4 : 3;
+    }
+
+    // Escaped string body (no quotes); stops early rather than overflow
+    void appendEscaped(const char* value) {
+        const char* p = value ? value : "";
+        while (*p) {
+            char esc[8];
+            size_t n = 0;
+            unsigned char c = (unsigned char)*p;
+            size_t consumed = 1;
+            if (c == '"' || c == '\\') {
+                esc[n++] = '\\'; esc[n++] = c;
+            } else if (c == '\n') {
+                esc[n++] = '\\'; esc[n++] = 'n';
+            } else if (c == '\r') {
+                esc[n++] = '\\'; esc[n++] = 'r';
+            } else if (c == '\t') {
+                esc[n++] = '\\'; esc[n++] = 't';
+            } else if (c < 0x20) {
+                n = snprintf(esc, sizeof(esc), "\\u%04x", c);
+            } else {
+                // Copy a whole UTF-8 sequence at once so truncation never splits it
+                consumed = (c >= 0xF0) ? 4 : (c >= 0xE0) ? 3 : (c >= 0xC0) ? 2 : 1;
+                for (n = 0; n < consumed && p[n]; n++) esc[n] = p[n];
+                consumed = n;
+            }
+            if (len + n + closing() > size) {  // Keep room for the closing quote and brackets
+                truncated = true;
+                break;
+            }
+            memcpy(buf + len, esc, n);
+            len += n;
+            p += consumed;
+        }
+    }
+
+    // Writes ,"key": (plus the opening quote for strings) if the whole member head fits
+    bool openMember(const char* key, bool quoted, size_t valueLen = 0) {
+        size_t keyLen = strlen(key);
+        size_t need = (len > 1 ? 1 : 0) + keyLen + 3 + (quoted ? 2 : valueLen);
+        if (len + need + 2 > size) {
+            truncated = true;
+            return false;
+        }
+        if (len > 1) buf[len++] = ',';
+        buf[len++] = '"';
+        memcpy(buf + len, key, keyLen);
+        len += keyLen;
+        buf[len++] = '"';
+        buf[len++] = ':';
+        if (quoted) buf[len++] = '"';
+        return true;
+    }
+};
+
+// Append one entry to the spill file. Returns false if it could not be stored.
+bool spillPublishEntry(const PublishEntry& entry) {
+    // Logs are dropped first when flash fills up; alerts get a reserved margin
+    size_t limit = PUBLISH_SPILL_MAX_SIZE;
+    if (entry.topics & (TOPIC_ALERT_LOG | TOPIC_EMAIL_ALERT)) limit += PUBLISH_SPILL_ALERT_RESERVE;
+
+    File file = SPIFFS.open(PUBLISH_SPILL_FILE, FILE_APPEND);
+    if (!file) return false;
+    bool ok = file.size() + 3 + entry.length <= limit &&
+              file.write(&entry.topics, 1) == 1 &&
+              file.write((const uint8_t*)&entry.length, 2) == 2 &&
+              file.write((const uint8_t*)entry.payload, entry.length) == entry.length;
+    file.close();
+    if (ok) spillPending = true;
+    return ok;
+}
+
+// Load the next spilled entry into spillEntry. Returns false when nothing is left.
+bool loadSpilledEntry() {
+    if (!spillPending) return false;
+    File file = SPIFFS.open(PUBLISH_SPILL_FILE, FILE_READ);
+    if (!file) {
+        spillPending = false;
+        return false;
+    }
+    bool ok = false;
+    if (spillReadOffset < file.size() && file.seek(spillReadOffset)) {
+        ok = file.read(&spillEntry.topics, 1) == 1 &&
+             file.read((uint8_t*)&spillEntry.length, 2) == 2 &&
+             spillEntry.length < MQTT_PAYLOAD_SIZE &&
+             file.read((uint8_t*)spillEntry.payload, spillEntry.length) == spillEntry.length;
+    }
+    file.close();
+    if (ok) {
+        spillEntry.payload[spillEntry.length] = '\0';
+        spillReadOffset += 3 + spillEntry.length;
+    } else {
+        // Fully replayed (or corrupt): start a fresh segment
+        SPIFFS.remove(PUBLISH_SPILL_FILE);
+        spillReadOffset = 0;
+        spillPending = false;
+    }
+    return ok;
+}
+
+// Queue a payload for the given TOPIC_* bits
+void enqueuePublish(uint8_t topics, const char* payload, size_t length) {
+    if (publishQueueCount == PUBLISH_QUEUE_SIZE) {
+        // Full: move the oldest entry to flash to make room
+        if (!spillPublishEntry(publishQueue[publishQueueHead])) {
+            publishDropped++;
+        }
+        publishQueueHead = (publishQueueHead + 1) % PUBLISH_QUEUE_SIZE;
+        publishQueueCount--;
+    }
+    PublishEntry& entry = publishQueue[(publishQueueHead + publishQueueCount) % PUBLISH_QUEUE_SIZE];
+    if (length >= MQTT_PAYLOAD_SIZE) length = MQTT_PAYLOAD_SIZE - 1;
+    entry.topics = topics;
+    entry.length = length;
+    memcpy(entry.payload, payload, length);
+    entry.payload[length] = '\0';
+    publishQueueCount++;
+}
+
+// Send an entry to each of its remaining topics. Topics that were sent are
+// cleared so a retry never duplicates them. Returns true when all were sent.
+bool sendPublishEntry(PublishEntry& entry) {
+    for (int i = 0; i < numPublishTopics; i++) {
+        uint8_t bit = 1 << i;
+        if (!(entry.topics & bit)) continue;
+        unsigned long start = halMicros();
+        bool sent = mqttClient.publish(publishTopics[i], (const uint8_t*)entry.payload, entry.length);
+        usf_hist_observe(&publishHist, halMicros() - start);
+        if (!sent) return false;
+        entry.topics &= ~bit;
+    }
+    return true;
 }
-    
-  
 
+// Send up to PUBLISH_BATCH_SIZE queued entries, spilled ones first
+void drainPublishQueue() {
+    if (!mqttClient.connected()) return;
+    int sent = 0;
+    while (sent < PUBLISH_BATCH_SIZE && (spillEntryLoaded || loadSpilledEntry())) {
+        spillEntryLoaded = true;
+        if (!sendPublishEntry(spillEntry)) return;
+        spillEntryLoaded = false;
+        sent++;
+    }
+    while (sent < PUBLISH_BATCH_SIZE && publishQueueCount > 0) {
+        if (!sendPublishEntry(publishQueue[publishQueueHead])) return;
+        publishQueueHead = (publishQueueHead + 1) % PUBLISH_QUEUE_SIZE;
+        publishQueueCount--;
+        sent++;
+    }
+}
+
+// Queue a {"type","message","timestamp"} log entry
+void publishTypedMessage(uint8_t topics, const char* type, const char* message) {
+    char payload[MQTT_PAYLOAD_SIZE];
+    JsonWriter json(payload, sizeof(payload));
+    json.add("type", type);
+    json.add("message", message);
+    json.add("timestamp", getTimestamp());
+    enqueuePublish(topics, payload, json.finish());
+}
+
+// Function to publish message via MQTT
+void publishMessage(const char* message) {
+  publishTypedMessage(TOPIC_MESSAGES | TOPIC_GENERAL_LOG, "info", message); // Also send to general log
+}
 
 // General log (info, error, warning, success)
-void publishGeneralLog(const String& msg, const char* type) {
-  if (!mqttClient.connected()) return;
-  String payload = "{\"type\":\"" + String(type) + "\",\"message\":\"" + msg + "\",\"timestamp\":\"" + getTimestamp() + "\"}";
-  mqttClient.publish(generalLogTopic, payload.c_str());
-  mqttClient.publish(mqttTopic, payload.c_str()); // Also send to main topic
+void publishGeneralLog(const char* msg, const char* type) {
+  publishTypedMessage(TOPIC_GENERAL_LOG | TOPIC_MESSAGES, type, msg); // Also send to main topic
 }
 
 // Command log
-void publishCommandLog(const String& msg) {
-  if (!mqttClient.connected()) return;
-  String payload = "{\"type\":\"command\",\"message\":\"" + msg + "\",\"timestamp\":\"" + getTimestamp() + "\"}";
-  mqttClient.publish(commandLogTopic, payload.c_str());
-  mqttClient.publish(mqttTopic, payload.c_str()); // Also send to main topic
+void publishCommandLog(const char* msg) {
+  publishTypedMessage(TOPIC_COMMAND_LOG | TOPIC_MESSAGES, "command", msg); // Also send to main topic
 }
 
 // Alert console log (red, amber, green)
-void publishAlert(const char* level, const String& msg) {
-    if (!mqttClient.connected()) return;
-
+void publishAlert(const char* level, const char* msg) {
     // Create LED status code string
-    String ledCode = "";
-    for (int i = 0; i < numLEDs; i++) {
-        ledCode += String(redLEDStates[i].lastState ? "1" : "0");
-    }
-    ledCode += "-";
+    char ledCode[2 * numLEDs + 2];
     for (int i = 0; i < numLEDs; i++) {
-        ledCode += String(greenLEDStates[i].lastState ? "1" : "0");
+        ledCode[i] = (reportedLEDPattern >> (LED_RED_SHIFT + i) & 1) ? '1' : '0';
+        ledCode[numLEDs + 1 + i] = (reportedLEDPattern >> (LED_GREEN_SHIFT + i) & 1) ? '1' : '0';
     }
-
-    // Create alert message
-    String alertMsg = String(level) + " Alert: " + msg;
-    
-    // Create JSON payload for alert topic
-    String alertPayload = "{\"type\":\"" + String(level) + "\",\"message\":\"" + msg + "\",\"led_code\":\"" + ledCode + "\",\"timestamp\":\"" + getTimestamp() + "\"}";
-    
-    // Create JSON payload for general topic with alert type
-    String generalPayload = "{\"type\":\"alert\",\"alert_type\":\"" + String(level) + "\",\"message\":\"" + msg + "\",\"led_code\":\"" + ledCode + "\",\"timestamp\":\"" + getTimestamp() + "\"}";
-
-    // Publish to alert topic
-    mqttClient.publish(alertLogTopic, alertPayload.c_str());
-    
-    // Also publish to general topic for the general tab
-    mqttClient.publish(generalLogTopic, generalPayload.c_str());
+    ledCode[numLEDs] = '-';
+    ledCode[2 * numLEDs + 1] = '\0';
+
+    char payload[MQTT_PAYLOAD_SIZE];
+
+    // JSON payload for alert topic
+    JsonWriter alertJson(payload, sizeof(payload));
+    alertJson.add("type", level);
+    alertJson.add("message", msg);
+    alertJson.add("led_code", ledCode);
+    alertJson.add("timestamp", getTimestamp());
+    enqueuePublish(TOPIC_ALERT_LOG, payload, alertJson.finish());
+
+    // JSON payload for general topic with alert type, for the general tab
+    JsonWriter generalJson(payload, sizeof(payload));
+    generalJson.add("type", "alert");
+    generalJson.add("alert_type", level);
+    generalJson.add("message", msg);
+    generalJson.add("led_code", ledCode);
+    generalJson.add("timestamp", getTimestamp());
+    enqueuePublish(TOPIC_GENERAL_LOG, payload, generalJson.finish());
     
     // Log to serial for debugging
     Serial.print("Publishing ");
@@ -357,6 +1081,22 @@ void publishAlert(const char* level, const String& msg) {
 
 // MQTT callback function
 void callback(char* topic, byte* payload, unsigned int length) {
+    uint32_t receivedUs = halMicros();
+
+    // Binary command frames are read in place, no copy or parse
+    if (strcmp(topic, binCommandTopic) == 0) {
+        const usf_frame_t* frame = usf_frame_view(payload, length);
+        if (frame && frame->type == USF_MSG_COMMAND && *usf_command_text(frame->command)) {
+            Serial.print("\n=== MQTT Command Received (binary) ===\n");
+            Serial.print("Command: ");
+            Serial.println(usf_command_text(frame->command));
+            // Echoed to the command log once carried out, so the dashboard console still sees HMI commands
+            queueIoCommand(ioCommands, IO_CMD_OUTPUT, frame->command | IO_OUTPUT_ECHO, receivedUs);
+            Serial.println("===========================\n");
+        }
+        return;
+    }
+
     // Create a null-terminated string from payload
     char message[length + 1];
     memcpy(message, payload, length);
@@ -375,114 +1115,160 @@ void callback(char* topic, byte* payload, unsigned int length) {
     const char* msg = doc["message"];
     const char* timestamp = doc["timestamp"];
 
-    // Only process command messages
-    if (type && strcmp(type, "command") == 0 && msg && timestamp) {
+    // Only process command messages that name an output command; the command log
+    // topic also carries this device's own "Command executed" echoes
+    uint8_t command = usf_command_from_text(msg);
+    if (type && strcmp(type, "command") == 0 && command != USF_CMD_NONE && timestamp) {
         Serial.print("\n=== MQTT Command Received ===\n");
         Serial.print("Command: ");
         Serial.println(msg);
         Serial.print("Time: ");
         Serial.println(timestamp);
 
-        // Command Output Pin Control with debug info
-        if (strcmp(msg, "COMMAND:UP") == 0) {
-            // Safety: First turn off DOWN
-            digitalWrite(DOWN_OUTPUT_PIN, LOW);
-            delay(10);  // Small delay for safety
-            
-            // Then activate UP
-            digitalWrite(UP_OUTPUT_PIN, HIGH);
-            
-            // Debug output
-            Serial.println("Setting UP_OUTPUT_PIN HIGH (3.3V)");
-            Serial.print("UP_OUTPUT_PIN state: ");
-            Serial.println(digitalRead(UP_OUTPUT_PIN));
-            Serial.print("DOWN_OUTPUT_PIN state: ");
-            Serial.println(digitalRead(DOWN_OUTPUT_PIN));
-        } 
-        else if (strcmp(msg, "COMMAND:DOWN") == 0) {
-            // Safety: First turn off UP
-            digitalWrite(UP_OUTPUT_PIN, LOW);
-            delay(10);  // Small delay for safety
-            
-            // Then activate DOWN
-            digitalWrite(DOWN_OUTPUT_PIN, HIGH);
-            
-            // Debug output
-            Serial.println("Setting DOWN_OUTPUT_PIN HIGH (3.3V)");
-            Serial.print("DOWN_OUTPUT_PIN state: ");
-            Serial.println(digitalRead(DOWN_OUTPUT_PIN));
-            Serial.print("UP_OUTPUT_PIN state: ");
-            Serial.println(digitalRead(UP_OUTPUT_PIN));
-        }
-        else if (strcmp(msg, "COMMAND:STOP") == 0) {
-            // Turn off both outputs
-            digitalWrite(UP_OUTPUT_PIN, LOW);
-            digitalWrite(DOWN_OUTPUT_PIN, LOW);
-            
-            // Debug output
-            Serial.println("Setting both output pins LOW (0V)");
-            Serial.print("UP_OUTPUT_PIN state: ");
-            Serial.println(digitalRead(UP_OUTPUT_PIN));
-            Serial.print("DOWN_OUTPUT_PIN state: ");
-            Serial.println(digitalRead(DOWN_OUTPUT_PIN));
-        }
+        queueIoCommand(ioCommands, IO_CMD_OUTPUT, command, receivedUs);
         Serial.println("===========================\n");
     }
 }
 
-// Function to reconnect to MQTT broker
+// Drive the output pins for a remote command (I/O task only). Reversing is
+// break-before-make: the opposite output goes LOW now and the requested one is
+// engaged by runIoCycle() once OUTPUT_DEADTIME_MS has passed, without blocking.
+// With echo set, the loop echoes the command once the output is set.
+void executeOutputCommand(uint8_t command, bool echo) {
+    if (command != USF_CMD_UP && command != USF_CMD_DOWN && command != USF_CMD_STOP) return;
+    ioPendingOutput = USF_CMD_NONE;
+    if (ioOutput != USF_CMD_STOP && ioOutput != command) {
+        ioWritePin(ioOutput == USF_CMD_UP ? UP_OUTPUT_PIN : DOWN_OUTPUT_PIN, LOW);
+        ioOutput = USF_CMD_STOP;
+        ioOutputReleasedAt = halMillis();
+    }
+    if (command == USF_CMD_STOP) {
+        postIoEvent(IO_EVT_OUTPUT, USF_CMD_STOP | (echo ? IO_OUTPUT_ECHO : 0));
+    } else if (outputLocked(command)) {
+        postIoEvent(IO_EVT_LOCKED, command == USF_CMD_UP ? USF_DIR_UP : USF_DIR_DOWN);
+    } else if (halMillis() - ioOutputReleasedAt >= OUTPUT_DEADTIME_MS) {
+        engageOutput(command, echo);
+    } else {
+        ioPendingOutput = command;
+        ioPendingEcho = echo;
+    }
+}
+
+// True if an active alarm locks the direction of a remote output command
+bool outputLocked(uint8_t command) {
+    if (command == USF_CMD_UP) return ioLockout & ALARM_ACTION_STOP_UP;
+    if (command == USF_CMD_DOWN) return ioLockout & ALARM_ACTION_STOP_DOWN;
+    return false;
+}
+
+// Drive one remote output HIGH (the other one is already LOW)
+void engageOutput(uint8_t command, bool echo) {
+    ioWritePin(command == USF_CMD_UP ? UP_OUTPUT_PIN : DOWN_OUTPUT_PIN, HIGH);
+    ioOutput = command;
+    ioPendingOutput = USF_CMD_NONE;
+    postIoEvent(IO_EVT_OUTPUT, command | (echo ? IO_OUTPUT_ECHO : 0));
+}
+
+// Debug output and status frame for an output command the I/O task carried out
+void reportOutputCommand(uint8_t command) {
+    if (command == USF_CMD_UP) {
+        Serial.println("Setting UP_OUTPUT_PIN HIGH (3.3V)");
+    } else if (command == USF_CMD_DOWN) {
+        Serial.println("Setting DOWN_OUTPUT_PIN HIGH (3.3V)");
+    } else {
+        Serial.println("Setting both output pins LOW (0V)");
+    }
+    Serial.print("UP_OUTPUT_PIN state: ");
+    Serial.println(halDigitalRead(UP_OUTPUT_PIN));
+    Serial.print("DOWN_OUTPUT_PIN state: ");
+    Serial.println(halDigitalRead(DOWN_OUTPUT_PIN));
+    publishStatusFrame(USF_MSG_STATUS);
+}
+
+// Direction reported in status frames: local movement or remote output command
+uint8_t statusDirection() {
+    if (currentDirection == "up" || halDigitalRead(UP_OUTPUT_PIN) == HIGH) return USF_DIR_UP;
+    if (currentDirection == "down" || halDigitalRead(DOWN_OUTPUT_PIN) == HIGH) return USF_DIR_DOWN;
+    return USF_DIR_STOP;
+}
+
+// Queue a usf_frame_t with the current LEDs, most severe alarm, direction and mode
+void publishStatusFrame(uint8_t type) {
+    usf_frame_t frame;
+    usf_frame_init(&frame, type, ++statusFrameSeq, halMillis());
+    frame.led_pattern = reportedLEDPattern;
+    frame.direction = statusDirection();
+    frame.mode = elevatorMode ? USF_MODE_ELEVATOR : USF_MODE_LIFT;
+
+    if (activeAlarms.red != ALARM_NONE) {
+        frame.alarm_level = USF_LEVEL_RED;
+        snprintf(frame.alarm_code, sizeof(frame.alarm_code), "%s", alarmTable[activeAlarms.red].code);
+    } else if (activeAlarms.amber != ALARM_NONE) {
+        frame.alarm_level = USF_LEVEL_AMBER;
+        snprintf(frame.alarm_code, sizeof(frame.alarm_code), "%s", alarmTable[activeAlarms.amber].code);
+    } else if (activeAlarms.green != ALARM_NONE) {
+        frame.alarm_level = USF_LEVEL_GREEN;
+        snprintf(frame.alarm_code, sizeof(frame.alarm_code), "%s", alarmTable[activeAlarms.green].code);
+    }
+    enqueuePublish(TOPIC_BIN_STATUS, (const char*)&frame, sizeof(frame));
+}
+
+// Function to reconnect to MQTT broker: one attempt per call. loop() calls it every
+// CHECK_INTERVAL, so a broker outage costs one connect() per interval, not a 10 s block.
 void reconnectMQTT() {
-    if (WiFi.status() != WL_CONNECTED) {
+    static int failedAttempts = 0;
+    const int MAX_ATTEMPTS = 3;  // Consecutive failures before it is reported
+    if (WiFi.status() != WL_CONNECTED || mqttClient.connected()) {
         return;
     }
-    int attempts = 0;
-    const int MAX_ATTEMPTS = 3;
-    while (!mqttClient.connected() && attempts < MAX_ATTEMPTS) {
-        String clientId = "ESP32Client-" + String(random(0xffff), HEX);
-        if (mqttClient.connect(clientId.c_str(), mqtt_username, mqtt_password)) {
-            Serial.println("Connected to MQTT broker");
-            
-            // Subscribe to topics
-            mqttClient.subscribe(commandLogTopic);
-            mqttClient.subscribe(generalLogTopic);
-            mqttClient.subscribe(alertLogTopic);
-            
-            // Send subscription confirmation to both topics
-            String subscribeMsg = "Subscribed to topics: " + String(commandLogTopic) + ", " + String(generalLogTopic) + ", " + String(alertLogTopic);
-            publishGeneralLog(subscribeMsg, "info");
-            
-            // Send connection message
-            publishGeneralLog("Device connected and ready", "info");
-            return;
-        }
-        attempts++;
-        if (attempts < MAX_ATTEMPTS) {
-            delay(5000);
-        }
+    String clientId = "ESP32Client-" + String(random(0xffff), HEX);
+    if (mqttClient.connect(clientId.c_str(), mqtt_username, mqtt_password)) {
+        Serial.println("Connected to MQTT broker");
+        failedAttempts = 0;
+        mqttConnects++;
+        
+        // Subscribe to topics
+        mqttClient.subscribe(commandLogTopic);
+        mqttClient.subscribe(generalLogTopic);
+        mqttClient.subscribe(alertLogTopic);
+        mqttClient.subscribe(binCommandTopic);
+        
+        // Send subscription confirmation to both topics
+        char subscribeMsg[160];
+        snprintf(subscribeMsg, sizeof(subscribeMsg), "Subscribed to topics: %s, %s, %s, %s",
+                 commandLogTopic, generalLogTopic, alertLogTopic, binCommandTopic);
+        publishGeneralLog(subscribeMsg, "info");
+        
+        // Send connection message
+        publishGeneralLog("Device connected and ready", "info");
+        publishStatusFrame(USF_MSG_STATUS);
+        return;
     }
-    if (!mqttClient.connected()) {
+    mqttConnectFailures++;
+    if (++failedAttempts == MAX_ATTEMPTS) {
         Serial.println("Failed to connect to MQTT after maximum attempts");
     }
 }
 
-bool sendAlarmEmail(String alarmType, String alarmMessage) {
-    if (!emailNotificationsEnabled || millis() - lastEmailSent < EMAIL_COOLDOWN) {
+bool sendAlarmEmail(const char* alarmType, const char* alarmMessage) {
+    if (!emailNotificationsEnabled || halMillis() - lastEmailSent < EMAIL_COOLDOWN) {
         Serial.println("Email not sent: notifications disabled or cooldown active");
         return false;
     }
     
-    // Instead of sending email directly, publish to MQTT for web interface to handle
-    if (mqttClient.connected()) {
-        String payload = "{\"type\":\"email_alert\",\"alert_type\":\"" + alarmType + 
-                        "\",\"message\":\"" + alarmMessage + 
-                        "\",\"timestamp\":\"" + getTimestamp() + "\"}";
-        Serial.println("Publishing email alert to MQTT: " + payload);
-        mqttClient.publish("usf/alerts/email", payload.c_str());
-        lastEmailSent = millis();
-        return true;
-    }
-    Serial.println("Email not sent: MQTT client not connected");
-    return false;
+    // Instead of sending email directly, publish to MQTT for web interface to handle.
+    // Queued, so it is delivered after the broker link comes back if it is down.
+    char payload[MQTT_PAYLOAD_SIZE];
+    JsonWriter json(payload, sizeof(payload));
+    json.add("type", "email_alert");
+    json.add("alert_type", alarmType);
+    json.add("message", alarmMessage);
+    json.add("timestamp", getTimestamp());
+    enqueuePublish(TOPIC_EMAIL_ALERT, payload, json.finish());
+    Serial.print("Publishing email alert to MQTT: ");
+    Serial.println(payload);
+    lastEmailSent = halMillis();
+    return true;
 }
 
 // ===== HTML Content ===== //
@@ -490,8 +1276,16 @@ bool sendAlarmEmail(String alarmType, String alarmMessage) {
 // Buffer sizes and optimization constants
 const size_t LOG_BUFFER_SIZE = 1024;  // 1KB buffer for logs
 const size_t MAX_LOG_SIZE = 2000;     // Maximum log size before truncation
+char serialLogs[MAX_LOG_SIZE + 1];    // Stored Logs on to send to the web interface (oldest dropped first)
+size_t serialLogsLength = 0;
+uint32_t serialLogsTotal = 0;         // Bytes ever appended to serialLogs (stream cursor)
 const unsigned long LOG_FLUSH_INTERVAL = 5000; // Flush log buffer every 5 seconds
 const size_t TIME_BUFFER_SIZE = 30;    // Buffer for timestamp strings
+const size_t LED_STATUS_BUFFER_SIZE = 288; // "Red LED n: FLASHING (nnnn ms)" lines for all 8 LEDs
+const size_t STATUS_MSG_BUFFER_SIZE = 64;  // "LED States - [..] [..] - Rxx/Gxx/Axx"
+char ledStatus[LED_STATUS_BUFFER_SIZE] = ""; // LED status info for the webpage
+const size_t LED_HISTORY_BUFFER_SIZE = 3000; // Recent status lines rendered from the event log
+const int LED_HISTORY_RECORDS = 64;          // Newest event records scanned for the history
 
 // Buffers for string operations
 char timeBuffer[TIME_BUFFER_SIZE];     // Reusable buffer for timestamps
@@ -534,440 +1328,864 @@ void addToLog(const String &message) {
     Serial.println(message);
 
     // Check if it's time to flush the buffer
-    if (millis() - lastLogFlush >= LOG_FLUSH_INTERVAL) {
+    if (halMillis() - lastLogFlush >= LOG_FLUSH_INTERVAL) {
         flushLogBuffer();
     }
 }
 
-// New function to flush log buffer
-void flushLogBuffer() {
-    if (logBufferIndex == 0) return;  // Nothing to flush
+// New function to flush log buffer
+void flushLogBuffer() {
+    if (logBufferIndex == 0) return;  // Nothing to flush
+
+    // Append to serialLogs with size limit, dropping the oldest text in place
+    if (serialLogsLength + logBufferIndex > MAX_LOG_SIZE) {
+        size_t drop = serialLogsLength + logBufferIndex - MAX_LOG_SIZE;
+        memmove(serialLogs, serialLogs + drop, serialLogsLength - drop);
+        serialLogsLength -= drop;
+    }
+    memcpy(serialLogs + serialLogsLength, logBuffer, logBufferIndex);
+    serialLogsLength += logBufferIndex;
+    serialLogsTotal += logBufferIndex;
+    serialLogs[serialLogsLength] = '\0';
+
+    // Reset buffer
+    logBufferIndex = 0;
+    lastLogFlush = halMillis();
+}
+
+// GPIO interrupt: timestamp one LED edge into its ring
+void IRAM_ATTR ledEdgeISR(void* arg) {
+    LEDEdgeRing* ring = (LEDEdgeRing*)arg;
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= LED_EDGE_RING_SIZE) {
+        ring->overflows.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring->time[head & LED_EDGE_RING_MASK] = halMicros();
+    ring->level[head & LED_EDGE_RING_MASK] = halDigitalRead(ring->pin);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+// Seed one LED from its current pin level and start capturing its edges
+void initLEDCapture(LEDState& led, LEDEdgeRing& ring, int pin) {
+    ring.pin = pin;
+    ring.head.store(0);
+    ring.tail.store(0);
+    ring.overflows.store(0);
+
+    led.currentState = halDigitalRead(pin);
+    led.lastState = led.currentState;
+    led.changeCount = 0;
+    led.lastChange = halMicros();
+    led.mode = led.currentState ? LED_MODE_ON : LED_MODE_OFF;
+    led.flashPeriod = 0;
+    led.lastInterval = 0;
+    led.flashEdges = 0;
+
+    halAttachEdgeInterrupt(pin, ledEdgeISR, &ring);
+}
+
+// Drain one LED's edge ring and classify it as OFF / ON / FLASHING from the
+// measured edge intervals. Returns true if the classified mode changed.
+bool updateLEDState(LEDState& led, LEDEdgeRing& ring) {
+    LEDMode prevMode = led.mode;
+    uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    uint32_t head = ring.head.load(std::memory_order_acquire);
+
+    for (; tail != head; tail++) {
+        unsigned long edgeTime = ring.time[tail & LED_EDGE_RING_MASK];
+        unsigned long interval = edgeTime - led.lastChange;
+        led.currentState = ring.level[tail & LED_EDGE_RING_MASK];
+        led.changeCount++;
+
+        // Contact bounce: take the level but keep the timing of the real edge
+        if (interval < LED_GLITCH_US) continue;
+
+        if (interval <= LED_FLASH_MAX_HALF_US) {
+            if (led.flashEdges < LED_FLASH_MIN_EDGES) led.flashEdges++;
+            if (led.flashEdges >= LED_FLASH_MIN_EDGES) {
+                led.flashPeriod = (led.lastInterval + interval) / 1000;
+            }
+            led.lastInterval = interval;
+        } else {
+            led.flashEdges = 1; // First edge after a steady period
+        }
+        led.lastChange = edgeTime;
+    }
+    ring.tail.store(tail, std::memory_order_release);
+
+    // Edges were dropped: the last captured level may be stale, so re-read the pin
+    if (ring.overflows.exchange(0, std::memory_order_relaxed) > 0) {
+        led.currentState = halDigitalRead(ring.pin);
+    }
+
+    // Sampled after draining so no captured edge is newer than "now"
+    unsigned long nowMicros = halMicros();
+    bool flashing = led.flashEdges >= LED_FLASH_MIN_EDGES &&
+                    nowMicros - led.lastChange <= LED_FLASH_MAX_HALF_US;
+    led.mode = flashing ? LED_MODE_FLASHING : led.currentState ? LED_MODE_ON : LED_MODE_OFF;
+    led.lastState = led.mode == LED_MODE_ON;
+    return led.mode != prevMode;
+}
+
+// Mode of one LED in a decoder pattern: 0 = OFF, 1 = ON, 2 = FLASHING
+LEDMode patternLEDMode(uint16_t pattern, bool green, int index) {
+    if (pattern >> ((green ? LED_GREEN_FLASH_SHIFT : LED_RED_FLASH_SHIFT) + index) & 1) return LED_MODE_FLASHING;
+    return (pattern >> ((green ? LED_GREEN_SHIFT : LED_RED_SHIFT) + index) & 1) ? LED_MODE_ON : LED_MODE_OFF;
+}
+
+const char* const ledStateNames[] = {"OFF", "ON", "FLASHING"};
+
+// Format "Red LED n: STATE" for the web UI, including the measured flash period
+int formatLEDStatus(char* buf, size_t size, const char* color, int index, LEDMode mode, unsigned long flashPeriod) {
+    if (mode == LED_MODE_FLASHING) {
+        return snprintf(buf, size, "%s LED %d: FLASHING (%lu ms)\n", color, index, flashPeriod);
+    }
+    return snprintf(buf, size, "%s LED %d: %s\n", color, index, ledStateNames[mode]);
+}
+
+// Optimized LED reading function (I/O task): consumes the edges captured by
+// ledEdgeISR(), applies the alarm interlocks as soon as the pattern changes, keeps
+// them latched in ioLockout while the pattern lasts and reports it to the loop
+void readDeviceOutputs() {
+    for (int i = 0; i < numLEDs; i++) {
+        updateLEDState(redLEDStates[i], redEdgeRings[i]);
+        updateLEDState(greenLEDStates[i], greenEdgeRings[i]);
+    }
+
+    uint16_t pattern = getLEDPattern();
+    if (pattern != ioLEDPattern) {
+        // Safety interlocks first
+        uint8_t actions = decodeLEDPattern(pattern).actions;
+        ioLockout = actions & ALARM_ACTION_STOP_BOTH;
+        if (actions & ALARM_ACTION_STOP_UP) stopUpMovement();
+        if (actions & ALARM_ACTION_STOP_DOWN) stopDownMovement();
+        if (outputLocked(ioOutput) || outputLocked(ioPendingOutput)) executeOutputCommand(USF_CMD_STOP, false);
+        ioLEDPattern = pattern;
+        ioLEDReported = false;
+    }
+
+    // Retried every cycle while the event ring is full
+    if (!ioLEDReported) {
+        IoEvent event = {};
+        event.type = IO_EVT_LED;
+        event.ledPattern = pattern;
+        for (int i = 0; i < numLEDs; i++) {
+            event.flashPeriod[i] = redLEDStates[i].flashPeriod;
+            event.flashPeriod[numLEDs + i] = greenLEDStates[i].flashPeriod;
+        }
+        ioLEDReported = ioEvents.push(event);
+    }
+}
+
+// Log, record and publish an LED pattern change reported by the I/O task
+void reportLEDStatus(const IoEvent& event) {
+    unsigned long currentMillis = halMillis();
+    static char tempStatus[LED_STATUS_BUFFER_SIZE];
+    reportedLEDPattern = event.ledPattern;
+
+    // Only log if enough time has passed
+    if (currentMillis - lastLEDStatusLog >= LED_STATUS_LOG_INTERVAL) {
+        char debugMsg[STATUS_MSG_BUFFER_SIZE];
+        int pos = snprintf(debugMsg, sizeof(debugMsg), "LED States - Red: ");
+        for (int i = 0; i < numLEDs; i++) {
+            pos += snprintf(debugMsg + pos, sizeof(debugMsg) - pos, "%d ", patternLEDMode(event.ledPattern, false, i));
+        }
+        pos += snprintf(debugMsg + pos, sizeof(debugMsg) - pos, "| Green: ");
+        for (int i = 0; i < numLEDs; i++) {
+            pos += snprintf(debugMsg + pos, sizeof(debugMsg) - pos, "%d ", patternLEDMode(event.ledPattern, true, i));
+        }
+        publishGeneralLog(debugMsg, "info");
+        lastLEDStatusLog = currentMillis;
+    }
+
+    // Build status string for display
+    size_t pos = 0;
+    for (int i = 0; i < numLEDs; i++) {
+        pos += formatLEDStatus(tempStatus + pos, sizeof(tempStatus) - pos, "Red", i,
+                               patternLEDMode(event.ledPattern, false, i), event.flashPeriod[i]);
+        pos += formatLEDStatus(tempStatus + pos, sizeof(tempStatus) - pos, "Green", i,
+                               patternLEDMode(event.ledPattern, true, i), event.flashPeriod[numLEDs + i]);
+    }
+    unsigned long start = halMicros();
+    processLEDStatus(tempStatus, event.ledPattern);
+    usf_hist_observe(&ledStatusHist, halMicros() - start);
+}
+
+// Pack the current LED states into a decoder pattern (see LED_*_SHIFT)
+uint16_t getLEDPattern() {
+    uint16_t pattern = 0;
+    for (int i = 0; i < numLEDs; i++) {
+        if (redLEDStates[i].lastState)          pattern |= 1 << (LED_RED_SHIFT + i);
+        if (greenLEDStates[i].lastState)        pattern |= 1 << (LED_GREEN_SHIFT + i);
+        if (redLEDStates[i].mode == LED_MODE_FLASHING)   pattern |= 1 << (LED_RED_FLASH_SHIFT + i);
+        if (greenLEDStates[i].mode == LED_MODE_FLASHING) pattern |= 1 << (LED_GREEN_FLASH_SHIFT + i);
+    }
+    return pattern;
+}
+
+// Decode an LED pattern into its red/green/amber alarms and required interlock actions.
+// Pure table lookups: no heap, no String compares.
+AlarmDecode decodeLEDPattern(uint16_t pattern) {
+    uint8_t red = (pattern >> LED_RED_SHIFT) & 0x0F;
+    uint8_t green = (pattern >> LED_GREEN_SHIFT) & 0x0F;
+    uint8_t redFlash = (pattern >> LED_RED_FLASH_SHIFT) & 0x0F;
+    uint8_t greenFlash = (pattern >> LED_GREEN_FLASH_SHIFT) & 0x0F;
+
+    // Amber = red and green lit together; it flashes if either half is flashing
+    uint8_t amber = red & green;
+    uint8_t amberFlash = (redFlash & greenFlash) | (redFlash & green) | (red & greenFlash);
+
+    AlarmDecode result = {ALARM_NONE, ALARM_NONE, ALARM_NONE, 0};
+
+    // RED ALARMS - Only if NO green LED is ON and NO amber is flashing
+    if (green == 0 && amberFlash == 0) {
+        result.red = redFlashAlarms[redFlash] != ALARM_NONE ? redFlashAlarms[redFlash] : redSteadyAlarms[red];
+    }
+
+    // GREEN ALARMS - Only if NO red LED is flashing
+    if (redFlash == 0) {
+        result.green = greenSteadyAlarms[green] != ALARM_NONE ? greenSteadyAlarms[green] : greenFlashAlarms[greenFlash];
+    }
+
+    // AMBER ALARMS (no mutual exclusion)
+    result.amber = amberFlashAlarms[amberFlash] != ALARM_NONE ? amberFlashAlarms[amberFlash] : amberSteadyAlarms[amber];
+
+    result.actions = alarmTable[result.red].actions | alarmTable[result.green].actions | alarmTable[result.amber].actions;
+    return result;
+}
+
+// New function to process LED status (the interlocks were already applied by the I/O task)
+void processLEDStatus(const char* tempStatus, uint16_t pattern) {
+    static char lastLedSnapshot[STATUS_MSG_BUFFER_SIZE] = "";
+    char statusMsg[STATUS_MSG_BUFFER_SIZE];
+
+    AlarmDecode alarms = decodeLEDPattern(pattern);
+
+    // Send email for any red alarm if it's different from the last one sent
+    if ((alarms.actions & ALARM_ACTION_EMAIL) && alarms.red != lastRedEmailSent) {
+        const AlarmInfo& info = alarmTable[alarms.red];
+        if (info.emailMessage) {
+            sendAlarmEmail("RED", info.emailMessage);
+        } else {
+            char emailMessage[96];
+            snprintf(emailMessage, sizeof(emailMessage), "%s - %s", info.code, info.description);
+            sendAlarmEmail("RED", emailMessage);
+        }
+        lastRedEmailSent = alarms.red;
+    }
+
+    // Build consolidated status message
+    formatStatusLine(statusMsg, sizeof(statusMsg), pattern, alarms);
+    bool hasAlerts = alarms.red != ALARM_NONE || alarms.green != ALARM_NONE || alarms.amber != ALARM_NONE;
+
+    // Only print the status message if there are alerts or LED states have changed
+    bool snapshotChanged = strcmp(statusMsg, lastLedSnapshot) != 0;
+    if (hasAlerts || snapshotChanged) {
+        Serial.println(statusMsg);
+        strcpy(lastLedSnapshot, statusMsg);
+    }
+
+    // Record the change: one LED record plus one per newly active alarm
+    logEvent(EVENT_LED_CHANGE, ALARM_NONE, pattern);
+    if (alarms.red != activeAlarms.red && alarms.red != ALARM_NONE) logEvent(EVENT_ALARM, alarms.red, pattern);
+    if (alarms.green != activeAlarms.green && alarms.green != ALARM_NONE) logEvent(EVENT_ALARM, alarms.green, pattern);
+    if (alarms.amber != activeAlarms.amber && alarms.amber != ALARM_NONE) logEvent(EVENT_ALARM, alarms.amber, pattern);
+
+    bool alarmsChanged = alarms.red != activeAlarms.red || alarms.green != activeAlarms.green ||
+                         alarms.amber != activeAlarms.amber;
+
+    // Alerts are published by publishAlarmAlerts() once the new alarms are stable
+    activeAlarms = alarms;
+    publishStatusFrame(alarmsChanged ? USF_MSG_ALARM : USF_MSG_STATUS);
+
+    // Update alarm codes for web interface (pointers into alarmTable, no copies)
+    if (alarms.red != ALARM_NONE) redAlarms = alarmTable[alarms.red].code;
+    if (alarms.green != ALARM_NONE) greenAlarms = alarmTable[alarms.green].code;
+    amberAlarms = alarmTable[alarms.amber].code;
+
+    // Update LED status for the web UI (history comes from the event log)
+    if (hasAlerts || snapshotChanged) {
+        strcpy(ledStatus, tempStatus); // Same size as tempStatus
+    }
+}
+
+// Format "LED States - [r0,r1,r2,r3] [g0,g1,g2,g3] - Rxx/Gxx/Axx" for a pattern and its alarms
+int formatStatusLine(char* buf, size_t size, uint16_t pattern, const AlarmDecode& alarms) {
+    int states[2 * numLEDs];
+    for (int i = 0; i < numLEDs; i++) {
+        states[i] = patternLEDMode(pattern, false, i);
+        states[numLEDs + i] = patternLEDMode(pattern, true, i);
+    }
+    int pos = snprintf(buf, size, "LED States - [%d,%d,%d,%d] [%d,%d,%d,%d]",
+                       states[0], states[1], states[2], states[3],
+                       states[4], states[5], states[6], states[7]);
+
+    bool first = true;
+    const AlarmCode codes[] = {alarms.red, alarms.green, alarms.amber};
+    for (AlarmCode code : codes) {
+        if (code == ALARM_NONE || pos >= (int)size) continue;
+        pos += snprintf(buf + pos, size - pos, "%s%s", first ? " - " : "/", alarmTable[code].code);
+        first = false;
+    }
+    return pos;
+}
+
+// Publish the decoded alarms once each has been stable for the debounce time.
+// Called on every LED check so steady alarms are published, not just changing ones.
+void publishAlarmAlerts(unsigned long currentMillis) {
+    const struct { AlertState& state; AlarmCode code; const char* level; } alerts[] = {
+        {redAlertState, activeAlarms.red, "red"},
+        {greenAlertState, activeAlarms.green, "green"},
+        {amberAlertState, activeAlarms.amber, "amber"},
+    };
+    for (const auto& alert : alerts) {
+        if (shouldPublishAlert(alert.state, alert.code, currentMillis)) {
+            char message[96];
+            snprintf(message, sizeof(message), "%s - %s", alarmTable[alert.code].code, alarmTable[alert.code].description);
+            publishAlert(alert.level, message);
+        }
+    }
+}
+
+// ===== Event Log =====
+
+// Colour bit of an alarm code (0 for ALARM_NONE)
+uint8_t alarmColour(uint8_t code) {
+    if (code >= ALARM_R01 && code <= ALARM_R05) return ALARM_COLOUR_RED;
+    if (code >= ALARM_G01 && code <= ALARM_G04) return ALARM_COLOUR_GREEN;
+    if (code >= ALARM_A01 && code <= ALARM_A38) return ALARM_COLOUR_AMBER;
+    return 0;
+}
+
+// File slot of a sequence number
+uint32_t eventSlot(uint32_t seq) {
+    return (seq - 1) % EVENT_LOG_CAPACITY;
+}
+
+// Oldest sequence number still held in the log
+uint32_t eventLogOldestSeq() {
+    return eventLogNewestSeq > EVENT_LOG_CAPACITY ? eventLogNewestSeq - EVENT_LOG_CAPACITY + 1 : 1;
+}
+
+// Rebuild the newest sequence number and page index from the log file
+void initEventLog() {
+    memset(eventLogPageColours, 0, sizeof(eventLogPageColours));
+    File file = SPIFFS.open(EVENT_LOG_FILE, FILE_READ);
+    if (file) {
+        EventRecord chunk[32];
+        uint32_t slot = 0;
+        size_t bytes;
+        while ((bytes = file.read((uint8_t*)chunk, sizeof(chunk))) >= sizeof(EventRecord)) {
+            for (size_t i = 0; i < bytes / sizeof(EventRecord); i++, slot++) {
+                const EventRecord& record = chunk[i];
+                if (record.seq == 0 || eventSlot(record.seq) != slot) continue;
+                if (record.seq > eventLogNewestSeq) eventLogNewestSeq = record.seq;
+                eventLogPageColours[slot / EVENT_LOG_PAGE_SIZE] |= alarmColour(record.alarm);
+            }
+        }
+        file.close();
+    }
+    eventLogFlushedSeq = eventLogNewestSeq;
+
+    // Colours already written to the current page this lap, so its index entry
+    // is still exact when the page is completed after the reboot
+    eventLogWritePageColours = 0;
+    uint32_t lapStart = eventLogNewestSeq + 1 - eventSlot(eventLogNewestSeq + 1) % EVENT_LOG_PAGE_SIZE;
+    if (lapStart <= eventLogNewestSeq) {
+        EventRecord chunk[32];
+        file = SPIFFS.open(EVENT_LOG_FILE, FILE_READ);
+        for (uint32_t seq = lapStart; seq <= eventLogNewestSeq;) {
+            uint32_t got = readEvents(seq, min(eventLogNewestSeq - seq + 1, (uint32_t)(sizeof(chunk) / sizeof(chunk[0]))), chunk, file);
+            if (got == 0) break;
+            for (uint32_t i = 0; i < got; i++) {
+                if (chunk[i].seq == seq + i) eventLogWritePageColours |= alarmColour(chunk[i].alarm);
+            }
+            seq += got;
+        }
+        if (file) file.close();
+    }
+    Serial.printf("Event log: %lu records, newest seq %lu\n",
+                  (unsigned long)(eventLogNewestSeq ? eventLogNewestSeq - eventLogOldestSeq() + 1 : 0),
+                  (unsigned long)eventLogNewestSeq);
+}
+
+// Extend the file with empty records up to slot. SPIFFS cannot seek past the
+// end, and records dropped by logEvent() leave a gap before the next slot.
+bool padEventLog(File& file, uint32_t slot) {
+    static const EventRecord empty = {};
+    size_t end = slot * sizeof(EventRecord);
+    if (file.size() >= end) return true;
+    if (!file.seek(file.size())) return false;
+    while (file.size() < end) {
+        size_t bytes = min(end - file.size(), sizeof(empty));
+        if (file.write((const uint8_t*)&empty, bytes) != bytes) return false;
+    }
+    return true;
+}
 
-    // Append to serialLogs with size limit
-    if (serialLogs.length() + logBufferIndex > MAX_LOG_SIZE) {
-        serialLogs = serialLogs.substring(serialLogs.length() - (MAX_LOG_SIZE - logBufferIndex));
+// Write the pending records to their slots in the log file. Only records that
+// reached flash leave the RAM batch; the rest are retried on the next flush.
+void flushEventLog() {
+    eventLogLastFlush = halMillis();
+    uint32_t count = eventLogNewestSeq - eventLogFlushedSeq;
+    if (count == 0) return;
+
+    uint32_t done = 0;
+    File file = SPIFFS.open(EVENT_LOG_FILE, SPIFFS.exists(EVENT_LOG_FILE) ? "r+" : "w");
+    bool opened = (bool)file;
+    if (opened) {
+        // One contiguous write, or two when the run wraps past the end of the file
+        while (done < count) {
+            uint32_t slot = eventSlot(eventLogFlushedSeq + 1 + done);
+            uint32_t run = min(count - done, (uint32_t)(EVENT_LOG_CAPACITY - slot));
+            size_t bytes = run * sizeof(EventRecord);
+            size_t written = 0;
+            if (padEventLog(file, slot) && file.seek(slot * sizeof(EventRecord))) {
+                written = file.write((const uint8_t*)&eventLogPending[done], bytes);
+            }
+            done += written / sizeof(EventRecord);  // A short write keeps its whole records
+            if (written != bytes) break;
+        }
+        file.close();
     }
-    serialLogs += String(logBuffer);
+    if (done < count) Serial.println(opened ? "Event log write failed" : "Event log open failed");
 
-    // Reset buffer
-    logBufferIndex = 0;
-    lastLogFlush = millis();
+    memmove(eventLogPending, eventLogPending + done, (count - done) * sizeof(EventRecord));
+    eventLogFlushedSeq += done;
 }
 
-// Optimized LED reading function
-void readDeviceOutputs() {
-    unsigned long currentMillis = millis();
-    static String tempStatus;
-    tempStatus.reserve(500);
-    
-    if (currentMillis - previousMillis >= LED_CHECK_DELAY) {
-        tempStatus = "";
-        bool significantChange = false;
+// Append one record to the log
+void logEvent(EventType type, AlarmCode alarm, uint16_t ledPattern) {
+    if (eventLogNewestSeq - eventLogFlushedSeq >= EVENT_LOG_PENDING_SIZE) {
+        flushEventLog();
+    }
+    if (eventLogNewestSeq - eventLogFlushedSeq >= EVENT_LOG_PENDING_SIZE) {
+        // Flash still refuses the batch: give up the oldest record, its slot becomes a gap
+        memmove(eventLogPending, eventLogPending + 1, (EVENT_LOG_PENDING_SIZE - 1) * sizeof(EventRecord));
+        eventLogFlushedSeq++;
+        eventLogDropped++;
+    }
 
-        // Read LED states and check for changes
-        for (int i = 0; i < numLEDs; i++) {
-            bool prevRedState = redLEDStates[i].currentState;
-            bool prevGreenState = greenLEDStates[i].currentState;
-            
-            redLEDStates[i].currentState = digitalRead(redLEDs[i]);
-            greenLEDStates[i].currentState = digitalRead(greenLEDs[i]);
-
-            if (redLEDStates[i].currentState != prevRedState || 
-                greenLEDStates[i].currentState != prevGreenState) {
-                significantChange = true;
-            }
+    EventRecord& record = eventLogPending[eventLogNewestSeq - eventLogFlushedSeq];
+    record.seq = ++eventLogNewestSeq;
+    time_t now = time(NULL);
+    record.timestamp = now > 1600000000 ? (uint32_t)now : 0;  // Unsynced clock reads near 1970
+    record.uptime = halMillis();
+    record.ledPattern = ledPattern;
+    record.type = type;
+    record.alarm = alarm;
+
+    // Page index: stays a superset while a page is being overwritten, then
+    // becomes exact once the whole page has been rewritten this lap
+    uint32_t slot = eventSlot(record.seq);
+    uint32_t page = slot / EVENT_LOG_PAGE_SIZE;
+    if (slot % EVENT_LOG_PAGE_SIZE == 0) eventLogWritePageColours = 0;
+    eventLogWritePageColours |= alarmColour(alarm);
+    eventLogPageColours[page] |= alarmColour(alarm);
+    if (slot % EVENT_LOG_PAGE_SIZE == EVENT_LOG_PAGE_SIZE - 1) {
+        eventLogPageColours[page] = eventLogWritePageColours;
+    }
+}
 
-            if (redLEDStates[i].currentState != redLEDStates[i].lastState) {
-                redLEDStates[i].changeCount++;
-                redLEDStates[i].lastState = redLEDStates[i].currentState;
-            }
+// Flush pending records once in a while even if the RAM batch is not full
+void serviceEventLog() {
+    if (eventLogNewestSeq != eventLogFlushedSeq && halMillis() - eventLogLastFlush >= EVENT_LOG_FLUSH_INTERVAL) {
+        flushEventLog();
+    }
+}
 
-            if (greenLEDStates[i].currentState != greenLEDStates[i].lastState) {
-                greenLEDStates[i].changeCount++;
-                greenLEDStates[i].lastState = greenLEDStates[i].currentState;
-            }
+// Read up to count consecutive records starting at firstSeq (from RAM or flash).
+// Returns the number of records read.
+uint32_t readEvents(uint32_t firstSeq, uint32_t count, EventRecord* out, File& file) {
+    uint32_t done = 0;
+    while (done < count) {
+        uint32_t seq = firstSeq + done;
+        if (seq > eventLogFlushedSeq) {
+            // Still in RAM
+            out[done] = eventLogPending[seq - eventLogFlushedSeq - 1];
+            done++;
+            continue;
         }
-
-        // Only log if there's a significant change and enough time has passed
-        if (significantChange && (currentMillis - lastLEDStatusLog >= LED_STATUS_LOG_INTERVAL)) {
-            String debugMsg = "LED States - Red: ";
-            for (int i = 0; i < numLEDs; i++) {
-                int redState = (redLEDStates[i].changeCount >= 2) ? 2 : redLEDStates[i].currentState ? 1 : 0;
-                debugMsg += String(redState) + " ";
-            }
-            debugMsg += "| Green: ";
-            for (int i = 0; i < numLEDs; i++) {
-                int greenState = (greenLEDStates[i].changeCount >= 2) ? 2 : greenLEDStates[i].currentState ? 1 : 0;
-                debugMsg += String(greenState) + " ";
-            }
-            publishGeneralLog(debugMsg, "info");
-            lastLEDStatusLog = currentMillis;
-            
-            // Reset change counters after logging
-            for (int i = 0; i < numLEDs; i++) {
-                redLEDStates[i].changeCount = 0;
-                greenLEDStates[i].changeCount = 0;
-            }
+        uint32_t slot = eventSlot(seq);
+        uint32_t run = min(count - done, min(eventLogFlushedSeq - seq + 1, (uint32_t)(EVENT_LOG_CAPACITY - slot)));
+        size_t bytes = run * sizeof(EventRecord);
+        size_t got = file && file.seek(slot * sizeof(EventRecord)) ? file.read((uint8_t*)&out[done], bytes) : 0;
+        if (got < bytes) {
+            // Past the end of the file: a gap left by dropped records reads as empty slots
+            memset((uint8_t*)&out[done] + got, 0, bytes - got);
         }
+        done += run;
+    }
+    return done;
+}
 
-        // Build status string for display
-        for (int i = 0; i < numLEDs; i++) {
-            tempStatus += "Red LED " + String(i) + ": ";
-            if (redLEDStates[i].changeCount >= 2) {
-                tempStatus += "FLASHING";
-            } else {
-                tempStatus += (redLEDStates[i].currentState ? "ON" : "OFF");
-            }
-            tempStatus += "\n";
-            
-            tempStatus += "Green LED " + String(i) + ": ";
-            if (greenLEDStates[i].changeCount >= 2) {
-                tempStatus += "FLASHING";
-            } else {
-                tempStatus += (greenLEDStates[i].currentState ? "ON" : "OFF");
-            }
-            tempStatus += "\n";
+// Page through the log: copies up to limit records with seq > since whose alarm colour
+// matches colourMask (0 = all records) into out. Returns the last seq examined, which
+// the client passes back as "since" for the next page.
+uint32_t queryEvents(uint32_t since, uint32_t limit, uint8_t colourMask, EventRecord* out, uint32_t& found) {
+    uint32_t seq = max(since + 1, eventLogOldestSeq());
+    uint32_t last = since;
+    found = 0;
+    File file = SPIFFS.open(EVENT_LOG_FILE, FILE_READ);
+    EventRecord chunk[16];
+
+    while (found < limit && seq <= eventLogNewestSeq) {
+        uint32_t slot = eventSlot(seq);
+        uint32_t pageEnd = seq + (EVENT_LOG_PAGE_SIZE - slot % EVENT_LOG_PAGE_SIZE);  // First seq of the next page
+        if (colourMask && !(eventLogPageColours[slot / EVENT_LOG_PAGE_SIZE] & colourMask)) {
+            // Nothing of these colours in this page
+            last = min(pageEnd - 1, eventLogNewestSeq);
+            seq = pageEnd;
+            continue;
         }
-
-        // Only process alarms if there were changes
-        if (significantChange) {
-            processLEDStatus(tempStatus, currentMillis);
+        uint32_t want = min(min(pageEnd, eventLogNewestSeq + 1) - seq, (uint32_t)(sizeof(chunk) / sizeof(chunk[0])));
+        uint32_t got = readEvents(seq, want, chunk, file);
+        if (got == 0) break;
+        for (uint32_t i = 0; i < got && found < limit; i++) {
+            last = seq + i;
+            if (chunk[i].seq != last) continue;  // Slot not written yet (e.g. after a failed flush)
+            if (colourMask && !(alarmColour(chunk[i].alarm) & colourMask)) continue;
+            out[found++] = chunk[i];
         }
-
-        previousMillis = currentMillis;
+        seq += got;
     }
+    if (file) file.close();
+    return last;
 }
 
-// New function to process LED status
-void processLEDStatus(const String& tempStatus, unsigned long currentMillis) {
-    static String lastRedAlarms = "";
-    static String lastAmberAlarms = "";
-    static String lastGreenAlarms = "";
-    static unsigned long lastAlertTime = 0;
-
-    // Create LED state string
-    String ledStateMsg = "LED States - [";
-    // Add Red LEDs
-    for (int i = 0; i < numLEDs; i++) {
-        int redState = (redLEDStates[i].changeCount >= 2) ? 2 : redLEDStates[i].currentState ? 1 : 0;
-        ledStateMsg += String(redState);
-        if (i < numLEDs - 1) ledStateMsg += ",";
+const char* const eventTypeNames[] = {"unknown", "boot", "led", "alarm"};
+const size_t EVENT_JSON_SIZE = 192;
+
+// One event record as a JSON object
+size_t formatEventJson(char* buf, size_t size, const EventRecord& record) {
+    JsonWriter json(buf, size);
+    char leds[8];
+    snprintf(leds, sizeof(leds), "0x%04x", record.ledPattern);
+    json.add("seq", (unsigned long)record.seq);
+    json.add("ts", (unsigned long)record.timestamp);
+    json.add("uptime", (unsigned long)record.uptime);
+    json.add("type", eventTypeNames[record.type < 4 ? record.type : 0]);
+    json.add("leds", leds);
+    if (record.type == EVENT_ALARM) {
+        uint8_t colour = alarmColour(record.alarm);
+        json.add("code", alarmTable[record.alarm < ALARM_CODE_COUNT ? record.alarm : 0].code);
+        json.add("colour", colour == ALARM_COLOUR_RED ? "red" : colour == ALARM_COLOUR_GREEN ? "green" : "amber");
     }
-    ledStateMsg += "] [";
-    // Add Green LEDs
-    for (int i = 0; i < numLEDs; i++) {
-        int greenState = (greenLEDStates[i].changeCount >= 2) ? 2 : greenLEDStates[i].currentState ? 1 : 0;
-        ledStateMsg += String(greenState);
-        if (i < numLEDs - 1) ledStateMsg += ",";
-    }
-    ledStateMsg += "]";
-
-    // === Declare shorthand LED state variables ===
-    bool r0 = redLEDStates[0].lastState;
-    bool r1 = redLEDStates[1].lastState;
-    bool r2 = redLEDStates[2].lastState;
-    bool r3 = redLEDStates[3].lastState;
-
-    bool g0 = greenLEDStates[0].lastState;
-    bool g1 = greenLEDStates[1].lastState;
-    bool g2 = greenLEDStates[2].lastState;
-    bool g3 = greenLEDStates[3].lastState;
-
-    // === Detect Flashing Based on State Changes ===
-    bool r0f = redLEDStates[0].changeCount >= 2;
-    bool r1f = redLEDStates[1].changeCount >= 2;
-    bool r2f = redLEDStates[2].changeCount >= 2;
-    bool r3f = redLEDStates[3].changeCount >= 2;
-
-    bool g0f = greenLEDStates[0].changeCount >= 2;
-    bool g1f = greenLEDStates[1].changeCount >= 2;
-    bool g2f = greenLEDStates[2].changeCount >= 2;
-    bool g3f = greenLEDStates[3].changeCount >= 2;
-
-    // === Amber Conditions Per LED ===
-    bool a0 = r0 && g0;
-    bool a1 = r1 && g1;
-    bool a2 = r2 && g2;
-    bool a3 = r3 && g3;
-
-    bool a0f = (r0f && g0f) || (r0f && g0) || (r0 && g0f);
-    bool a1f = (r1f && g1f) || (r1f && g1) || (r1 && g1f);
-    bool a2f = (r2f && g2f) || (r2f && g2) || (r2 && g2f);
-    bool a3f = (r3f && g3f) || (r3f && g3) || (r3 && g3f);
-
-    String currentRedAlarms = "";
-    String currentAmberAlarms = "";
-    String currentGreenAlarms = "";
-
-    // === Mutual Exclusion Logic ===
-    bool anyGreenOn = false;
-    bool anyRedFlashing = false;
-    for (int i = 0; i < numLEDs; i++) {
-        if (greenLEDStates[i].lastState) anyGreenOn = true;
-        if (redLEDStates[i].changeCount >= 2) anyRedFlashing = true;
+    return json.finish();
+}
+
+// Render the newest LED status lines (newest first) for /getStatus
+const char* formatLedHistory() {
+    static char history[LED_HISTORY_BUFFER_SIZE];
+    EventRecord records[LED_HISTORY_RECORDS];
+    size_t pos = 0;
+    history[0] = '\0';
+    if (eventLogNewestSeq == 0) return history;
+
+    uint32_t first = max(eventLogOldestSeq(), eventLogNewestSeq >= LED_HISTORY_RECORDS ? eventLogNewestSeq - LED_HISTORY_RECORDS + 1 : 1);
+    File file = SPIFFS.open(EVENT_LOG_FILE, FILE_READ);
+    uint32_t count = readEvents(first, eventLogNewestSeq - first + 1, records, file);
+    if (file) file.close();
+
+    for (int i = (int)count - 1; i >= 0; i--) {
+        if (records[i].seq != first + i || records[i].type != EVENT_LED_CHANGE) continue;
+        char line[STATUS_MSG_BUFFER_SIZE];
+        int len = formatStatusLine(line, sizeof(line), records[i].ledPattern, decodeLEDPattern(records[i].ledPattern));
+        if (pos + len + 2 > sizeof(history)) break;
+        memcpy(history + pos, line, len);
+        pos += len;
+        history[pos++] = '\n';
+        history[pos] = '\0';
     }
-    bool anyAmberFlashing = a0f || a1f || a2f || a3f;
+    return history;
+}
 
-    // Build consolidated status message
-    String statusMsg = ledStateMsg;
-    bool hasAlerts = false;
+// Comma-separated colour list ("red,amber") as ALARM_COLOUR_* bits, 0 if any name is unknown
+uint8_t parseColourList(const char* list) {
+    uint8_t mask = 0;
+    while (*list) {
+        size_t len = strcspn(list, ",");
+        if (len == 3 && strncmp(list, "red", 3) == 0) mask |= ALARM_COLOUR_RED;
+        else if (len == 5 && strncmp(list, "amber", 5) == 0) mask |= ALARM_COLOUR_AMBER;
+        else if (len == 5 && strncmp(list, "green", 5) == 0) mask |= ALARM_COLOUR_GREEN;
+        else return 0;
+        list += len;
+        if (*list == ',') list++;
+    }
+    return mask;
+}
 
-    // RED ALARMS - Only if NO green LED is ON and NO amber is flashing
-    if (!anyGreenOn && !anyAmberFlashing) {
-        String alertName = "";
-        if (!r0 && !r1 && !r2 && !r3) {
-            alertName = "R01"; // All RED LEDs are OFF
-        } else if (r0 && r1 && r2 && r3) {
-            alertName = "R02"; // E-Stop is OFF
-            stopUpMovement();
-            stopDownMovement();
-        } else if (r0 && r1 && r2 && !r3) {
-            alertName = "R15"; // OSG/Pit Switch
-            stopUpMovement();
-            stopDownMovement();
-        } else if (r0 && r1 && !r2 && !r3) {
-            alertName = "R23"; // Door Lock Failure
-            stopUpMovement();
-            stopDownMovement();
-        } else if (!r0 && !r1 && r2 && r3) {
-            alertName = "R22"; // Door Open
-            stopUpMovement();
-            stopDownMovement();
-        }
-        // Flashing LED conditions
-        if (!r0f && !r1f && !r2f && !r3f) {
-            alertName = "R00"; // No FLASHING RED LEDs
-            stopUpMovement();
-            stopDownMovement();
-        } else if (!r0f && r1f && !r2f && !r3f) {
-            alertName = "R31"; // Out of Service (flood switch)
-            stopUpMovement();
-            stopDownMovement();
-        } else if (!r0f && r1f && r2f && r3f) {
-            alertName = "R36"; // Out of Service – periodic maintenance
-            stopUpMovement();
-            stopDownMovement();
-        } else if (r0f && !r1f && !r2f && !r3f) {
-            alertName = "R37"; // Out of Service (travel time)
-            stopUpMovement();
-            stopDownMovement();
-        } else if (!r0f && r1f && !r2f && r3f) {
-            alertName = "R07"; // Drive Train, Belt Failure
-            stopUpMovement();
-            stopDownMovement();
-        } else if (r0f && r1f && r2f && r3f) {
-            alertName = "R03"; // Drive Nut Friction block fails
-            stopUpMovement();
-            stopDownMovement();
-        } else if (r0f && !r1f && !r2f && r3f) {
-            alertName = "R27"; // Drive Train Alignment
-            stopUpMovement();
-            stopDownMovement();
-        } else if (r0f && r1f && r2f && !r3f) {
-            alertName = "R10"; // Final Limit
-            stopUpMovement();
-            stopDownMovement();
-            // Send email for R10 alarm
-            if (alertName != lastRedEmailSent) {
-                sendAlarmEmail("RED", "Final Limit (R10) - Lift has reached final limit switch");
-                lastRedEmailSent = alertName;
-            }
-        } else if (!r0f && !r1f && r2f && !r3f) {
-            alertName = "R11"; // Landing Switch (Top) failure
-            stopUpMovement();
-            stopDownMovement();
-        } else if (!r0f && r1f && r2f && !r3f) {
-            alertName = "R12"; // Landing Switch (Mid) failure
-            stopUpMovement();
-            stopDownMovement();
-        } else if (r0f && !r1f && r2f && !r3f) {
-            alertName = "R13"; // Landing Switch (Bottom) failure
-            stopUpMovement();
-            stopDownMovement();
-        } else if (!r0f && !r1f && r2f && r3f) {
-            alertName = "R24"; // Drive Train Motor Failure
-            stopUpMovement();
-            stopDownMovement();
-        } else if (!r0f && !r1f && !r2f && r3f) {
-            alertName = "R05"; // Motor temperature failure
-            stopUpMovement();
-            stopDownMovement();
+// GET /events?since=<seq>&limit=<n>&colour=red,amber,green
+// A limit that is not a positive number, or an unknown colour, is a 400
+void handleEventsQuery() {
+    if (!isAuthenticated()) {
+        server.send(401, "text/plain", "Unauthorized");
+        return;
+    }
+    uint32_t since = server.hasArg("since") ? strtoul(server.arg("since").c_str(), NULL, 10) : 0;
+    long limit = EVENT_QUERY_DEFAULT_LIMIT;
+    if (server.hasArg("limit")) {
+        String text = server.arg("limit");
+        char* end;
+        limit = strtol(text.c_str(), &end, 10);
+        if (end == text.c_str() || *end != '\0' || limit <= 0) {
+            server.send(400, "text/plain", "limit must be a positive number");
+            return;
         }
-        if (alertName != "") {
-            currentRedAlarms = alertName;
-            statusMsg += " - " + alertName;
-            hasAlerts = true;
-            
-            // Send email for any red alarm if it's different from the last one sent
-            if (alertName != lastRedEmailSent) {
-                String alertDescription = getAlertDescription(alertName);
-                sendAlarmEmail("RED", alertName + " - " + alertDescription);
-                lastRedEmailSent = alertName;
-            }
+        if (limit > EVENT_QUERY_MAX_LIMIT) limit = EVENT_QUERY_MAX_LIMIT;
+    }
+    uint8_t colourMask = 0;
+    if (server.hasArg("colour")) {
+        colourMask = parseColourList(server.arg("colour").c_str());
+        if (colourMask == 0) {
+            server.send(400, "text/plain", "colour must list red, amber or green");
+            return;
         }
     }
 
-    // GREEN ALARMS - Only if NO red LED is flashing
-    if (!anyRedFlashing) {
-        String alertName = "";
-        if (!g0 && !g1 && !g2 && !g3) {
-            alertName = "G01"; // All GREEN LEDs are OFF
-        } else if (g0 && g1 && g2 && g3) {
-            alertName = "G00"; // No exceptions
-        } else if (!g0f && !g1f && !g2f && !g3f) {
-            alertName = "G02"; // No FLASHING GREEN LEDs
-        } else if (g0f && g1f && g2f && !g3f) {
-            alertName = "G03"; // On Battery Power
-        } else if (g0f && g1f && g2f && g3f) {
-            alertName = "G04"; // Bypass Jumpers/Service Switch
-        }
-        if (alertName != "") {
-            currentGreenAlarms = alertName;
-            statusMsg += (hasAlerts ? "/" : " - ") + alertName;
-            hasAlerts = true;
+    static EventRecord results[EVENT_QUERY_MAX_LIMIT];
+    uint32_t found;
+    uint32_t last = queryEvents(since, limit, colourMask, results, found);
+
+    // Stream the response in chunks rather than building one large String
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+    char chunk[512];
+    size_t pos = snprintf(chunk, sizeof(chunk), "{\"oldest\":%lu,\"newest\":%lu,\"events\":[",
+                          (unsigned long)eventLogOldestSeq(), (unsigned long)eventLogNewestSeq);
+    for (uint32_t n = 0; n < found; n++) {
+        char item[EVENT_JSON_SIZE];
+        size_t len = formatEventJson(item, sizeof(item), results[n]);
+        if (pos + len + 1 >= sizeof(chunk)) {
+            server.sendContent(chunk, pos);
+            pos = 0;
         }
+        if (n > 0) chunk[pos++] = ',';
+        memcpy(chunk + pos, item, len);
+        pos += len;
     }
 
-    // AMBER ALARMS (no mutual exclusion)
-    String alertName = "";
-    if (!a0 && !a1 && !a2 && !a3) {
-        alertName = "A01"; // ALL AMBER LEDs OFF
-    } else if (a0 && a1 && a2 && !a3) {
-        alertName = "A04"; // Power Failure
-    } else if (!a0 && a1 && a2 && a3) {
-        alertName = "A39"; // Power Failure
-    } else if (a0 && !a1 && !a2 && !a3) {
-        alertName = "A30"; // Service Required (Flood switch)
-    } else if (!a0 && a1 && !a2 && !a3) {
-        alertName = "A33"; // Service Required – travel time
-    } else if (a0 && a1 && !a2 && !a3) {
-        alertName = "A34"; // Service Required – maintenance
-    } else if (!a0 && !a1 && a2 && !a3) {
-        alertName = "A35"; // Service Required – hours
-    } else if (!a0 && !a1 && a2 && a3) {
-        alertName = "A36"; // Service Required – Battery
-    } else if (a0 && !a1 && !a2 && a3) {
-        alertName = "A37"; // Service Required - Inverter
-    }
-    // Flashing amber conditions
-    if (!a0f && !a1f && !a2f && !a3f) {
-        alertName = "A02"; // No FLASHING AMBER LEDs
-    } else if (a0f && a1f && a2f && !a3f) {
-        alertName = "A32"; // Power Failure - UP Locked
-        stopUpMovement();
-    } else if (!a0f && a1f && a2f && a3f) {
-        alertName = "A40"; // Power Failure
-    } else if (!a0f && !a1f && a2f && !a3f) {
-        alertName = "A06"; // Motor Failure - UP Locked
-        stopUpMovement();
-    } else if (a0f && !a1f && !a2f && a3f) {
-        alertName = "A08"; // Anti-Rock binding - UP Locked
-        stopUpMovement();
-    } else if (a0f && a1f && !a2f && !a3f) {
-        alertName = "A14"; // Bottom Final Limit - DOWN Locked
-        stopDownMovement();
-    } else if (!a0f && a1f && !a2f && !a3f) {
-        alertName = "A16"; // Flood waters - DOWN Locked
-        stopDownMovement();
-    } else if (!a0f && a1f && a2f && !a3f) {
-        alertName = "A38"; // Motor Temperature monitoring lost
-    }
-    if (alertName != "") {
-        currentAmberAlarms = alertName;
-        statusMsg += (hasAlerts ? "/" : " - ") + alertName;
-        hasAlerts = true;
-    }
+    pos += snprintf(chunk + pos, sizeof(chunk) - pos, "],\"next\":%lu}", (unsigned long)last);
+    server.sendContent(chunk, pos);
+    server.sendContent("");
+}
 
-    // Only print the status message if there are alerts or LED states have changed
-    if (hasAlerts || statusMsg != lastLedSnapshot) {
-        Serial.println(statusMsg);
-        lastLedSnapshot = statusMsg;
+// ===== Status Streaming =====
+
+StatusCursor currentStatusCursor() {
+    StatusCursor cursor = {eventLogNewestSeq, serialLogsTotal, configRevision};
+    return cursor;
+}
+
+bool sameStatusCursor(const StatusCursor& a, const StatusCursor& b) {
+    return a.eventSeq == b.eventSeq && a.logBytes == b.logBytes && a.configRev == b.configRev;
+}
+
+// A cursor from before a reboot can be ahead of this boot's event log or log
+// text. A delta from it would skip whatever fills that range, so such a client
+// gets a snapshot and a fresh cursor instead.
+bool statusCursorAhead(const StatusCursor& cursor) {
+    return cursor.eventSeq > eventLogNewestSeq || cursor.logBytes > serialLogsTotal;
+}
+
+void formatStatusCursor(char* buf, size_t size, const StatusCursor& cursor) {
+    snprintf(buf, size, "%lu-%lu-%lu", (unsigned long)cursor.eventSeq,
+             (unsigned long)cursor.logBytes, (unsigned long)cursor.configRev);
+}
+
+// Accepts the cursor bare or as a quoted ETag
+bool parseStatusCursor(const char* text, StatusCursor& cursor) {
+    unsigned long eventSeq, logBytes, configRev;
+    if (*text == '"') text++;
+    if (sscanf(text, "%lu-%lu-%lu", &eventSeq, &logBytes, &configRev) != 3) return false;
+    cursor.eventSeq = eventSeq;
+    cursor.logBytes = logBytes;
+    cursor.configRev = configRev;
+    return true;
+}
+
+// Build the status JSON into buf. A snapshot has every field; a delta only has what
+// changed after cursor. Either way cursor is advanced to exactly what was included.
+size_t formatStatusJson(char* buf, size_t size, StatusCursor& cursor, bool delta) {
+    JsonWriter json(buf, size);
+    if (delta) json.add("delta", true);
+
+    // LED state and alarms: new event records (deltas) or the rendered history (snapshots)
+    if (!delta || cursor.eventSeq != eventLogNewestSeq) {
+        json.add("ledStatus", ledStatus);
+        json.add("greenAlarms", greenAlarms);
+        json.add("amberAlarms", amberAlarms);
+        json.add("redAlarms", redAlarms);
+        if (delta) {
+            EventRecord records[STATUS_DELTA_MAX_EVENTS];
+            uint32_t found;
+            uint32_t last = queryEvents(cursor.eventSeq, STATUS_DELTA_MAX_EVENTS, 0, records, found);
+            if (json.beginArray("events")) {
+                uint32_t n = 0;
+                for (; n < found; n++) {
+                    char item[EVENT_JSON_SIZE];
+                    size_t len = formatEventJson(item, sizeof(item), records[n]);
+                    if (!json.appendElement(item, len)) break;
+                }
+                json.endArray();
+                // Resume after the last record that fit
+                cursor.eventSeq = n == found ? last : records[n].seq - 1;
+            }
+        } else {
+            json.add("ledStatusHistory", formatLedHistory());
+            cursor.eventSeq = eventLogNewestSeq;
+        }
     }
 
-    // Process alerts with state management
-    if (shouldPublishAlert(redAlertState, currentRedAlarms, currentMillis)) {
-        String alertDescription = getAlertDescription(currentRedAlarms);
-        publishAlert("red", currentRedAlarms + " - " + alertDescription);
+    // Log text appended since the cursor, or the whole buffer if that part was dropped
+    if (!delta || cursor.logBytes != serialLogsTotal) {
+        uint32_t logStart = serialLogsTotal - serialLogsLength;
+        const char* text = serialLogs;
+        if (delta) {
+            if (cursor.logBytes >= logStart && cursor.logBytes <= serialLogsTotal) {
+                text += cursor.logBytes - logStart;
+            } else {
+                json.add("logsReset", true);
+            }
+        }
+        json.add("logs", text);
+        cursor.logBytes = serialLogsTotal;
     }
 
-    if (shouldPublishAlert(greenAlertState, currentGreenAlarms, currentMillis)) {
-        String alertDescription = getAlertDescription(currentGreenAlarms);
-        publishAlert("green", currentGreenAlarms + " - " + alertDescription);
+    if (!delta || cursor.configRev != configRevision) {
+        char delayText[12];
+        snprintf(delayText, sizeof(delayText), "%lu", elevatorMode ? ELEVATOR_MODE_DELAY : LIFT_MODE_DELAY);
+        json.add("mode", elevatorMode ? "elevator" : "lift");
+        json.add("delay", delayText);
+        json.add("emailEnabled", emailNotificationsEnabled);
+        if (json.beginArray("emails")) {
+            for (int i = 0; i < emailCount; i++) {
+                json.appendString(emailAddresses[i].c_str());
+            }
+            json.endArray();
+        }
+        cursor.configRev = configRevision;
     }
 
-    if (shouldPublishAlert(amberAlertState, currentAmberAlarms, currentMillis)) {
-        String alertDescription = getAlertDescription(currentAmberAlarms);
-        publishAlert("amber", currentAmberAlarms + " - " + alertDescription);
+    char cursorText[40];
+    formatStatusCursor(cursorText, sizeof(cursorText), cursor);
+    json.add("cursor", cursorText);
+    return json.finish();
+}
+
+void sendStatusNotModified(const StatusCursor& cursor) {
+    char etag[44];
+    char cursorText[40];
+    formatStatusCursor(cursorText, sizeof(cursorText), cursor);
+    snprintf(etag, sizeof(etag), "\"%s\"", cursorText);
+    server.sendHeader("ETag", etag);
+    server.send(304);
+}
+
+// GET /getStatus: full snapshot, 304 when If-None-Match is current, or
+// ?since=<cursor> for only what changed after that cursor
+void handleGetStatus() {
+    if (!isAuthenticated()) return;
+    StatusCursor current = currentStatusCursor();
+    StatusCursor cursor = {0, 0, 0};
+    bool delta = server.hasArg("since") && parseStatusCursor(server.arg("since").c_str(), cursor) &&
+                 !statusCursorAhead(cursor);
+
+    StatusCursor seen;
+    if ((delta && sameStatusCursor(cursor, current)) ||
+        (!delta && server.hasHeader("If-None-Match") &&
+         parseStatusCursor(server.header("If-None-Match").c_str(), seen) && sameStatusCursor(seen, current))) {
+        sendStatusNotModified(current);
+        return;
     }
 
-    // Update global strings for web interface
-    if (currentRedAlarms != "") redAlarms = currentRedAlarms;
-    if (currentGreenAlarms != "") greenAlarms = currentGreenAlarms;
-    amberAlarms = currentAmberAlarms;
+    size_t len = formatStatusJson(statusJson, sizeof(statusJson), cursor, delta);
+    char etag[44];
+    char cursorText[40];
+    formatStatusCursor(cursorText, sizeof(cursorText), cursor);
+    snprintf(etag, sizeof(etag), "\"%s\"", cursorText);
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Cache-Control", "no-cache");
+    server.setContentLength(len);
+    server.send(200, "application/json", "");
+    server.sendContent(statusJson, len);
+}
 
-    // Update LED history
-    if (hasAlerts || statusMsg != lastLedSnapshot) {
-        ledStatus = tempStatus;
-        ledStatusHistory = statusMsg + "\n" + ledStatusHistory;
-        
-        // Trim history to prevent memory issues
-        if (ledStatusHistory.length() > 3000) {
-            ledStatusHistory = ledStatusHistory.substring(0, 3000);
+// Write one SSE event ("snapshot" or "delta") to a stream client. Returns false if the write failed.
+bool sendStreamUpdate(StreamClient& stream, bool delta) {
+    size_t len = formatStatusJson(statusJson, sizeof(statusJson), stream.cursor, delta);
+    char cursorText[40];
+    char head[80];
+    formatStatusCursor(cursorText, sizeof(cursorText), stream.cursor);
+    size_t headLen = snprintf(head, sizeof(head), "id: %s\nevent: %s\ndata: ", cursorText, delta ? "delta" : "snapshot");
+    stream.lastSend = halMillis();
+    return stream.client.write((const uint8_t*)head, headLen) == headLen &&
+           stream.client.write((const uint8_t*)statusJson, len) == len &&
+           stream.client.write((const uint8_t*)"\n\n", 2) == 2;
+}
+
+// GET /stream: Server-Sent Events. One snapshot (or a delta when the browser
+// reconnects with Last-Event-ID), then deltas from serviceStatusStream().
+void handleStatusStream() {
+    if (!isAuthenticated()) {
+        server.send(401, "text/plain", "Unauthorized");
+        return;
+    }
+    StreamClient* stream = NULL;
+    for (StreamClient& candidate : streamClients) {
+        if (candidate.active && !candidate.client.connected()) {
+            candidate.client.stop();
+            candidate.active = false;
         }
+        if (!candidate.active && !stream) stream = &candidate;
+    }
+    if (!stream) {
+        server.send(503, "text/plain", "Too many stream clients");
+        return;
     }
+
+    // The connection outlives this handler, so write the response head directly
+    stream->client = server.client();
+    stream->client.setNoDelay(true);
+    stream->client.print("HTTP/1.1 200 OK\r\n"
+                         "Content-Type: text/event-stream\r\n"
+                         "Cache-Control: no-cache\r\n"
+                         "Connection: keep-alive\r\n\r\n");
+    stream->cursor = {0, 0, 0};
+    bool delta = server.hasHeader("Last-Event-ID") &&
+                 parseStatusCursor(server.header("Last-Event-ID").c_str(), stream->cursor) &&
+                 !statusCursorAhead(stream->cursor);
+    stream->active = sendStreamUpdate(*stream, delta);
+    if (!stream->active) stream->client.stop();
 }
 
-// Add a helper function to get alert descriptions
-String getAlertDescription(const String& alertCode) {
-    if (alertCode == "R01") return "All RED LEDs are OFF";
-    else if (alertCode == "R02") return "E-Stop is OFF";
-    else if (alertCode == "R15") return "OSG/Pit Switch activated";
-    else if (alertCode == "R23") return "Door Lock Failure";
-    else if (alertCode == "R22") return "Door Open";
-    else if (alertCode == "R00") return "No FLASHING RED LEDs";
-    else if (alertCode == "R31") return "Out of Service (flood switch)";
-    else if (alertCode == "R36") return "Out of Service – periodic maintenance";
-    else if (alertCode == "R37") return "Out of Service (travel time)";
-    else if (alertCode == "R07") return "Drive Train, Belt Failure";
-    else if (alertCode == "R03") return "Drive Nut Friction block fails";
-    else if (alertCode == "R27") return "Drive Train Alignment";
-    else if (alertCode == "R10") return "Final Limit";
-    else if (alertCode == "R11") return "Landing Switch (Top) failure";
-    else if (alertCode == "R12") return "Landing Switch (Mid) failure";
-    else if (alertCode == "R13") return "Landing Switch (Bottom) failure";
-    else if (alertCode == "R24") return "Drive Train Motor Failure";
-    else if (alertCode == "R05") return "Motor temperature failure";
-    
-    // Green alerts
-    else if (alertCode == "G01") return "All GREEN LEDs are OFF";
-    else if (alertCode == "G00") return "No exceptions";
-    else if (alertCode == "G02") return "No FLASHING GREEN LEDs";
-    else if (alertCode == "G03") return "On Battery Power";
-    else if (alertCode == "G04") return "Bypass Jumpers/Service Switch";
-    
-    // Amber alerts
-    else if (alertCode == "A01") return "ALL AMBER LEDs OFF";
-    else if (alertCode == "A04") return "Power Failure";
-    else if (alertCode == "A39") return "Power Failure";
-    else if (alertCode == "A30") return "Service Required (Flood switch)";
-    else if (alertCode == "A33") return "Service Required – travel time";
-    else if (alertCode == "A34") return "Service Required – maintenance";
-    else if (alertCode == "A35") return "Service Required – hours";
-    else if (alertCode == "A36") return "Service Required – Battery";
-    else if (alertCode == "A37") return "Service Required - Inverter";
-    else if (alertCode == "A02") return "No FLASHING AMBER LEDs";
-    else if (alertCode == "A32") return "Power Failure - UP Locked";
-    else if (alertCode == "A40") return "Power Failure";
-    else if (alertCode == "A06") return "Motor Failure - UP Locked";
-    else if (alertCode == "A08") return "Anti-Rock binding - UP Locked";
-    else if (alertCode == "A14") return "Bottom Final Limit - DOWN Locked";
-    else if (alertCode == "A16") return "Flood waters - DOWN Locked";
-    else if (alertCode == "A38") return "Motor Temperature monitoring lost";
-    
-    return "Unknown Alert Code";
+// Push deltas to stream clients whose cursor is behind, and drop dead connections
+void serviceStatusStream() {
+    unsigned long now = halMillis();
+    if (now - lastStreamPush < STREAM_PUSH_INTERVAL) return;
+    lastStreamPush = now;
+
+    StatusCursor current = currentStatusCursor();
+    for (StreamClient& stream : streamClients) {
+        if (!stream.active) continue;
+        bool ok = stream.client.connected();
+        if (ok && !sameStatusCursor(stream.cursor, current)) {
+            ok = sendStreamUpdate(stream, true);
+        } else if (ok && now - stream.lastSend >= STREAM_KEEPALIVE_INTERVAL) {
+            ok = stream.client.print(": keepalive\n\n") > 0;
+            stream.lastSend = now;
+        }
+        if (!ok) {
+            stream.client.stop();
+            stream.active = false;
+        }
+    }
 }
 
 void OnDataRecv(const esp_now_recv_info_t *info, const uint8_t *incomingData, int len) {
+  uint32_t receivedUs = halMicros();
+
   // Print sender MAC address
   char macStr[18];
   snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
@@ -986,15 +2204,16 @@ void OnDataRecv(const esp_now_recv_info_t *info, const uint8_t *incomingData, in
 
   // If it's a command, trigger the appropriate action
   // Update this in your OnDataRecv function
+// This runs on the WiFi task, so the I/O task carries the command out
 if (strcmp(incomingDataStruct.type, "command") == 0) {
   String cmd = String(incomingDataStruct.payload);
-  if (cmd == "UP") handleMovement("up");
-  else if (cmd == "DOWN") handleMovement("down");
-  else if (cmd == "STOP") stopMovement();
-  else if (cmd == "BRAKE") applyBrake();
-  else if (cmd == "RELEASE_BRAKE") releaseBrake();
-  else if (cmd == "STOP_UP") stopUpMovement();
-  else if (cmd == "STOP_DOWN") stopDownMovement();
+  if (cmd == "UP") queueIoCommand(espNowCommands, IO_CMD_MOVE, USF_DIR_UP, receivedUs);
+  else if (cmd == "DOWN") queueIoCommand(espNowCommands, IO_CMD_MOVE, USF_DIR_DOWN, receivedUs);
+  else if (cmd == "STOP") queueIoCommand(espNowCommands, IO_CMD_MOVE, USF_DIR_STOP, receivedUs);
+  else if (cmd == "BRAKE") queueIoCommand(espNowCommands, IO_CMD_BRAKE, 1, receivedUs);
+  else if (cmd == "RELEASE_BRAKE") queueIoCommand(espNowCommands, IO_CMD_BRAKE, 0, receivedUs);
+  else if (cmd == "STOP_UP") queueIoCommand(espNowCommands, IO_CMD_STOP_UP, 0, receivedUs);
+  else if (cmd == "STOP_DOWN") queueIoCommand(espNowCommands, IO_CMD_STOP_DOWN, 0, receivedUs);
 }
 }
 
@@ -1046,6 +2265,13 @@ void setup() {
   }
   Serial.println("SPIFFS Initialized Successfully");
 
+  // Publishes spilled before a reboot are replayed once MQTT connects
+  spillPending = SPIFFS.exists(PUBLISH_SPILL_FILE);
+
+  // Resume the event log after the newest stored record
+  initEventLog();
+  logEvent(EVENT_BOOT, ALARM_NONE, 0);
+
   // Check if required files exist
   if(!SPIFFS.exists("/index.html")) {
     Serial.println("Warning: index.html not found in SPIFFS");
@@ -1056,40 +2282,37 @@ void setup() {
   // Initialize LED pins and states
   Serial.println("Initializing LED pins...");
   for (int i = 0; i < numLEDs; i++) {
-    pinMode(redLEDs[i], INPUT);
-    pinMode(greenLEDs[i], INPUT);
-    // Initialize LED states
-    redLEDStates[i].currentState = false;
-    redLEDStates[i].lastState = false;
-    redLEDStates[i].changeCount = 0;
-    redLEDStates[i].lastChange = 0;
-    
-    greenLEDStates[i].currentState = false;
-    greenLEDStates[i].lastState = false;
-    greenLEDStates[i].changeCount = 0;
-    greenLEDStates[i].lastChange = 0;
+    halPinMode(redLEDs[i], INPUT);
+    halPinMode(greenLEDs[i], INPUT);
+    // Initialize LED states and attach the edge capture interrupts
+    initLEDCapture(redLEDStates[i], redEdgeRings[i], redLEDs[i]);
+    initLEDCapture(greenLEDStates[i], greenEdgeRings[i], greenLEDs[i]);
   }
   Serial.println("LED pins initialized");
 
   // Initialize GPIO with explicit states
   Serial.println("Initializing GPIO pins...");
-  pinMode(UP_PIN, OUTPUT);
-  digitalWrite(UP_PIN, LOW);
-  pinMode(DOWN_PIN, OUTPUT);
-  digitalWrite(DOWN_PIN, LOW);
+  halPinMode(UP_PIN, OUTPUT);
+  halDigitalWrite(UP_PIN, LOW);
+  halPinMode(DOWN_PIN, OUTPUT);
+  halDigitalWrite(DOWN_PIN, LOW);
   
   // Use INPUT_PULLUP for buttons with stronger pull-up
-  pinMode(UP_BUTTON, INPUT_PULLUP);
-  pinMode(DOWN_BUTTON, INPUT_PULLUP);
+  halPinMode(UP_BUTTON, INPUT_PULLUP);
+  halPinMode(DOWN_BUTTON, INPUT_PULLUP);
   
-  pinMode(BRAKE_PIN, OUTPUT);
-  digitalWrite(BRAKE_PIN, LOW);
+  halPinMode(BRAKE_PIN, OUTPUT);
+  halDigitalWrite(BRAKE_PIN, LOW);
   
   // Initialize output pins with explicit states
-  pinMode(UP_OUTPUT_PIN, OUTPUT);
-  digitalWrite(UP_OUTPUT_PIN, LOW);    // Start with output OFF
-  pinMode(DOWN_OUTPUT_PIN, OUTPUT);
-  digitalWrite(DOWN_OUTPUT_PIN, LOW);   // Start with output OFF
+  halPinMode(UP_OUTPUT_PIN, OUTPUT);
+  halDigitalWrite(UP_OUTPUT_PIN, LOW);    // Start with output OFF
+  halPinMode(DOWN_OUTPUT_PIN, OUTPUT);
+  halDigitalWrite(DOWN_OUTPUT_PIN, LOW);   // Start with output OFF
+
+  // Buttons, LED interlocks and relays run on their own core from here on,
+  // including while WiFi, MQTT and NTP below are still connecting
+  xTaskCreatePinnedToCore(ioTask, "ioTask", IO_TASK_STACK_SIZE, NULL, IO_TASK_PRIORITY, &ioTaskHandle, IO_TASK_CORE);
 
   // Initialize always-HIGH output pins
   //pinMode(ALWAYS_HIGH_PIN1, OUTPUT);
@@ -1129,6 +2352,7 @@ void setup() {
   mqttClient.setCallback(callback);
   mqttClient.setKeepAlive(60);
   mqttClient.setSocketTimeout(10);
+  mqttClient.setBufferSize(MQTT_PAYLOAD_SIZE + 128); // Room for topic + header around a full payload
   
   // Initial MQTT connection attempt
   reconnectMQTT();
@@ -1168,30 +2392,13 @@ void setup() {
     file.close();
   });
 
-  server.on("/getStatus", HTTP_GET, []() {
-    if (!isAuthenticated()) return;
-    String response = "{";
-    response += "\"mode\":\"" + String(elevatorMode ? "elevator" : "lift") + "\",";
-    response += "\"delay\":\"" + String(elevatorMode ? ELEVATOR_MODE_DELAY : LIFT_MODE_DELAY) + "\",";
-    response += "\"logs\":\"" + serialLogs + "\",";
-    response += "\"ledStatus\":\"" + ledStatus + "\",";
-    response += "\"ledStatusHistory\":\"" + ledStatusHistory + "\",";
-    response += "\"greenAlarms\":\"" + greenAlarms + "\",";
-    response += "\"amberAlarms\":\"" + amberAlarms + "\",";
-    response += "\"redAlarms\":\"" + redAlarms + "\",";
-    response += "\"emailEnabled\":" + String(emailNotificationsEnabled ? "true" : "false") + ",";
-    response += "\"emails\":[";
-    for (int i = 0; i < emailCount; i++) {
-      if (i > 0) response += ",";
-      response += "\"" + emailAddresses[i] + "\"";
-    }
-    response += "]}";
-    server.send(200, "application/json", response);
-  });
+  server.on("/getStatus", HTTP_GET, handleGetStatus);
+  server.on("/stream", HTTP_GET, handleStatusStream);
 
   server.on("/toggleEmail", HTTP_GET, []() {
     if (!isAuthenticated()) return;
     emailNotificationsEnabled = server.arg("enabled") == "true";
+    configRevision++;
     server.send(200, "text/plain", "Email notifications " + String(emailNotificationsEnabled ? "enabled" : "disabled"));
   });
 
@@ -1210,6 +2417,7 @@ void setup() {
       }
     }
     emailAddresses[emailCount++] = email;
+    configRevision++;
     server.send(200, "text/plain", "Email added successfully");
   });
 
@@ -1225,9 +2433,17 @@ void setup() {
       emailAddresses[i] = emailAddresses[i + 1];
     }
     emailCount--;
+    configRevision++;
     server.send(200, "text/plain", "Email removed successfully");
   });
 
+  server.on("/events", HTTP_GET, handleEventsQuery);
+  server.on("/metrics", HTTP_GET, handleMetrics);
+
+  // The server only keeps headers it is told to collect
+  const char* headerKeys[] = {"Cookie", "If-None-Match", "Last-Event-ID"};
+  server.collectHeaders(headerKeys, sizeof(headerKeys) / sizeof(headerKeys[0]));
+
   // Start the server
   server.begin();
   Serial.println("HTTP server started");
@@ -1243,7 +2459,8 @@ void loop() {
     static unsigned long lastLoopDelay = 0;
     const unsigned long CHECK_INTERVAL = 5000;
     const unsigned long WDT_RESET_INTERVAL = 1000;
-    unsigned long currentMillis = millis();
+    unsigned long currentMillis = halMillis();
+    unsigned long loopStart = halMicros();
 
     // No need to manually reset the watchdog unless you have a long-running operation
     // If you add a long-running section, call esp_task_wdt_reset() there
@@ -1252,6 +2469,7 @@ void loop() {
         if (WiFi.status() != WL_CONNECTED) {
             WiFi.disconnect();
             WiFi.begin(ssid, password);
+            wifiReconnects++;
         }
         lastWiFiCheck = currentMillis;
     }
@@ -1264,11 +2482,45 @@ void loop() {
     if (mqttClient.connected()) {
         mqttClient.loop();
     }
-    readDeviceOutputs();
+    drainPublishQueue();
+    serviceIoEvents();
+    serviceEventLog();
+    server.handleClient();
+    serviceStatusStream();
+#if IO_JITTER_TEST
+    serviceJitterTest();
+#endif
+    if (currentMillis - lastHealthCheck >= HEALTH_CHECK_INTERVAL) {
+        publishMetrics();
+        lastHealthCheck = currentMillis;
+    }
     
+    if (elevatorMode) {
+        static bool lastUpLimit = false;
+        static bool lastDownLimit = false;
+        if (currentDirection == "up") {
+            // Movement continues without limit switch check
+        }
+        if (currentDirection == "down") {
+            // Movement continues without limit switch check
+        }
+    }
+
+    // Replace delay(10) with non-blocking delay
+    if (currentMillis - lastLoopDelay >= 5) {  // 5ms instead of 10ms
+        lastLoopDelay = currentMillis;
+        yield();  // Allow other tasks to run
+    }
+    usf_hist_observe(&loopHist, halMicros() - loopStart);
+}
+
+// Debounce the UP/DOWN buttons and start or stop movement on press/release (I/O task)
+void serviceButtons() {
+    unsigned long currentMillis = halMillis();
+
     // Read the current state of buttons
-    int upReading = digitalRead(UP_BUTTON);
-    int downReading = digitalRead(DOWN_BUTTON);
+    int upReading = halDigitalRead(UP_BUTTON);
+    int downReading = halDigitalRead(DOWN_BUTTON);
     
     // Handle UP button with debounce
     if (upReading != lastUpButtonState) {
@@ -1280,7 +2532,7 @@ void loop() {
             upButtonState = upReading;
             if (upButtonState == LOW && !upButtonPressed) {  // Button is newly pressed
                 upButtonPressed = true;
-                handleMovement("up");
+                handleMovement(USF_DIR_UP);
             } else if (upButtonState == HIGH && upButtonPressed) {  // Button is released
                 upButtonPressed = false;
                 if (!elevatorMode) {  // Only stop on release in lift mode
@@ -1300,7 +2552,7 @@ void loop() {
             downButtonState = downReading;
             if (downButtonState == LOW && !downButtonPressed) {  // Button is newly pressed
                 downButtonPressed = true;
-                handleMovement("down");
+                handleMovement(USF_DIR_DOWN);
             } else if (downButtonState == HIGH && downButtonPressed) {  // Button is released
                 downButtonPressed = false;
                 if (!elevatorMode) {  // Only stop on release in lift mode
@@ -1313,39 +2565,403 @@ void loop() {
     // Save the button readings for next loop
     lastUpButtonState = upReading;
     lastDownButtonState = downReading;
-    
-    if (elevatorMode) {
-        static bool lastUpLimit = false;
-        static bool lastDownLimit = false;
-        if (currentDirection == "up") {
-            // Movement continues without limit switch check
+}
+
+// ===== I/O Task =====
+
+// Fixed-rate I/O loop; its period deviation is what the jitter mode reports
+void ioTask(void* arg) {
+    TickType_t lastWake = xTaskGetTickCount();
+    unsigned long lastCycle = halMicros();
+    for (;;) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(IO_TASK_PERIOD_MS));
+        unsigned long now = halMicros();
+        recordIoJitter(now - lastCycle);
+        lastCycle = now;
+        runIoCycle();
+    }
+}
+
+// One I/O cycle: refused state events, queued commands, buttons, LEDs and
+// interlocks, then a reversed output once its dead time is over
+void runIoCycle() {
+    retryIoEvents();
+    IoCommand command;
+    while (ioCommands.pop(command)) executeIoCommand(command);
+    while (espNowCommands.pop(command)) executeIoCommand(command);
+    serviceButtons();
+    unsigned long start = halMicros();
+    readDeviceOutputs();
+    usf_hist_observe(&ledScanHist, halMicros() - start);
+    if (ioPendingOutput != USF_CMD_NONE && halMillis() - ioOutputReleasedAt >= OUTPUT_DEADTIME_MS) {
+        engageOutput(ioPendingOutput, ioPendingEcho);
+        usf_hist_observe(&commandHist, halMicros() - ioPendingReceivedUs);
+    }
+}
+
+void executeIoCommand(const IoCommand& command) {
+    uint32_t changesBefore = ioPinChanges;
+    switch (command.type) {
+        case IO_CMD_OUTPUT:
+            executeOutputCommand(command.arg & ~IO_OUTPUT_ECHO, command.arg & IO_OUTPUT_ECHO);
+            break;
+        case IO_CMD_MOVE:
+            if (command.arg == USF_DIR_STOP) stopMovement();
+            else handleMovement(command.arg);
+            break;
+        case IO_CMD_STOP_UP:
+            stopUpMovement();
+            break;
+        case IO_CMD_STOP_DOWN:
+            stopDownMovement();
+            break;
+        case IO_CMD_BRAKE:
+            if (command.arg) applyBrake();
+            else releaseBrake();
+            break;
+    }
+    // Latency is received -> pin changed, so refused or repeated commands are not observed
+    if (command.type == IO_CMD_OUTPUT && ioPendingOutput != USF_CMD_NONE) {
+        ioPendingReceivedUs = command.receivedUs; // Observed once the dead time is over
+    } else if (ioPinChanges != changesBefore) {
+        usf_hist_observe(&commandHist, halMicros() - command.receivedUs);
+    }
+}
+
+// Report a pin change to the loop. A full ring never drops the action, and the
+// newest direction, brake and output events wait in ioUnreported until there is
+// room, so the loop ends up agreeing with the pins. IO_EVT_LOCKED is dropped.
+void postIoEvent(uint8_t type, uint8_t arg) {
+    IoEvent event = {};
+    event.type = type;
+    event.arg = arg;
+    int slot = ioStateSlot(type);
+    if (slot >= 0 && (ioUnreportedMask & (1 << slot))) {
+        ioUnreported[slot] = event; // An older one is still waiting: replace it, keep the order
+        return;
+    }
+    if (ioEvents.push(event) || slot < 0) return;
+    ioUnreported[slot] = event;
+    ioUnreportedMask |= 1 << slot;
+}
+
+int ioStateSlot(uint8_t type) {
+    switch (type) {
+        case IO_EVT_MOVE:
+        case IO_EVT_HALT:
+            return IO_SLOT_DIRECTION;
+        case IO_EVT_BRAKE:
+            return IO_SLOT_BRAKE;
+        case IO_EVT_OUTPUT:
+            return IO_SLOT_OUTPUT;
+        default:
+            return -1;
+    }
+}
+
+// Post the state events a full ring refused, retried every cycle like the LED event
+void retryIoEvents() {
+    for (int slot = 0; slot < IO_SLOT_COUNT && ioUnreportedMask; slot++) {
+        if ((ioUnreportedMask & (1 << slot)) && ioEvents.push(ioUnreported[slot])) {
+            ioUnreportedMask &= ~(1 << slot);
         }
-        if (currentDirection == "down") {
-            // Movement continues without limit switch check
+    }
+}
+
+void recordIoJitter(unsigned long periodUs) {
+    const unsigned long nominalUs = IO_TASK_PERIOD_MS * 1000UL;
+    uint32_t deviation = periodUs > nominalUs ? periodUs - nominalUs : nominalUs - periodUs;
+    if (deviation > ioJitterMaxUs.load(std::memory_order_relaxed)) {
+        ioJitterMaxUs.store(deviation, std::memory_order_relaxed);
+    }
+    ioJitterSumUs.fetch_add(deviation, std::memory_order_relaxed);
+    ioJitterCycles.fetch_add(1, std::memory_order_relaxed);
+    if (deviation > IO_JITTER_LATE_US) ioJitterLate.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Hand a command to the I/O task (the caller must be the queue's only producer)
+bool queueIoCommand(IoQueue<IoCommand>& queue, uint8_t type, uint8_t arg, uint32_t receivedUs) {
+    IoCommand command = {type, arg, receivedUs};
+    if (queue.push(command)) return true;
+    Serial.println("I/O command queue full, command dropped");
+    return false;
+}
+
+// Log and publish what the I/O task did, and publish the stable alarms (loop)
+void serviceIoEvents() {
+    IoEvent event;
+    while (ioEvents.pop(event)) {
+        switch (event.type) {
+            case IO_EVT_MOVE:
+                // Add prominent Serial output for lift commands
+                Serial.println("\n=== LIFT COMMAND RECEIVED ===");
+                Serial.print("Direction: ");
+                Serial.println(event.arg == USF_DIR_UP ? "up" : event.arg == USF_DIR_DOWN ? "down" : "STOP");
+                Serial.println("===========================\n");
+                if (event.arg == USF_DIR_UP) {
+                    currentDirection = "up";
+                    addToLog("Moving up");
+                    publishCommandLog("Command executed: UP");
+                    publishGeneralLog("Moving up", "info");
+                } else if (event.arg == USF_DIR_DOWN) {
+                    currentDirection = "down";
+                    addToLog("Moving down");
+                    publishCommandLog("Command executed: DOWN");
+                    publishGeneralLog("Moving down", "info");
+                } else {
+                    currentDirection = "stop";
+                    addToLog("Movement stopped");
+                    publishCommandLog("Command executed: STOP");
+                    publishGeneralLog("Movement stopped", "info");
+                }
+                publishStatusFrame(USF_MSG_STATUS);
+                break;
+            case IO_EVT_HALT:
+                currentDirection = "none";
+                addToLog(event.arg == USF_DIR_UP ? "Stopped upward movement" : "Stopped downward movement");
+                break;
+            case IO_EVT_BRAKE:
+                addToLog(event.arg ? "Brake applied" : "Brake released");
+                break;
+            case IO_EVT_OUTPUT:
+                reportOutputCommand(event.arg & ~IO_OUTPUT_ECHO);
+                if (event.arg & IO_OUTPUT_ECHO) {
+                    char logMsg[48];
+                    snprintf(logMsg, sizeof(logMsg), "Command executed: %s",
+                             usf_command_text(event.arg & ~IO_OUTPUT_ECHO));
+                    publishCommandLog(logMsg);
+                }
+                break;
+            case IO_EVT_LED:
+                reportLEDStatus(event);
+                break;
+            case IO_EVT_LOCKED: {
+                const char* msg = event.arg == USF_DIR_UP ? "UP refused: locked by an active alarm"
+                                                          : "DOWN refused: locked by an active alarm";
+                addToLog(msg);
+                publishGeneralLog(msg, "warning");
+                break;
+            }
         }
     }
 
-    // Replace delay(10) with non-blocking delay
-    if (currentMillis - lastLoopDelay >= 5) {  // 5ms instead of 10ms
-        lastLoopDelay = currentMillis;
-        yield();  // Allow other tasks to run
+    // Steady alarms are published once stable, not just on changes
+    unsigned long currentMillis = halMillis();
+    if (currentMillis - previousMillis >= LED_CHECK_DELAY) {
+        publishAlarmAlerts(currentMillis);
+        previousMillis = currentMillis;
+    }
+}
+
+// Jitter measurement mode (IO_JITTER_TEST): network load from the I/O task's core,
+// which also keeps the WiFi driver and lwIP busy on the other one. Floods UDP to
+// the gateway, then makes a blocking TLS connect to a blackholed host, for as
+// long as ioJitterLoad is set.
+void jitterLoadTask(void* arg) {
+    static uint8_t packet[1024];
+    WiFiUDP udp;
+    WiFiClientSecure tls;
+    tls.setInsecure();
+    for (;;) {
+        if (!ioJitterLoad.load(std::memory_order_relaxed) || WiFi.status() != WL_CONNECTED) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+        ioJitterLoadRunning.store(true, std::memory_order_relaxed);
+        unsigned long start = halMillis();
+        while (ioJitterLoad.load(std::memory_order_relaxed) && halMillis() - start < IO_JITTER_UDP_BURST_MS) {
+            if (udp.beginPacket(WiFi.gatewayIP(), IO_JITTER_UDP_PORT)) {
+                udp.write(packet, sizeof(packet));
+                if (udp.endPacket()) ioJitterUdpPackets.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        tls.connect(IO_JITTER_BLACKHOLE, IO_JITTER_TLS_PORT, IO_JITTER_TLS_TIMEOUT_MS);
+        tls.stop();
+        ioJitterTlsConnects.fetch_add(1, std::memory_order_relaxed);
+        ioJitterLoadRunning.store(false, std::memory_order_relaxed);
+    }
+}
+
+// Alternate idle and load phases of IO_JITTER_PHASE_MS and report the I/O period
+// deviation of each
+void serviceJitterTest() {
+    static TaskHandle_t loadTask = NULL;
+    static unsigned long phaseStart = 0;
+    static unsigned long lastCall = 0;
+    static unsigned long maxLoopGap = 0;
+    unsigned long currentMillis = halMillis();
+
+    if (!loadTask) {
+        xTaskCreatePinnedToCore(jitterLoadTask, "jitterLoad", IO_JITTER_LOAD_STACK_SIZE, NULL,
+                                IO_JITTER_LOAD_PRIORITY, &loadTask, IO_TASK_CORE);
+        phaseStart = currentMillis;
+    }
+
+    // Longest time between two loop passes, which the load task shares the core with
+    if (lastCall != 0 && currentMillis - lastCall > maxLoopGap) maxLoopGap = currentMillis - lastCall;
+    lastCall = currentMillis;
+
+    // An idle phase starts once the load task's last TLS connect has timed out
+    if (!ioJitterLoad.load(std::memory_order_relaxed) && ioJitterLoadRunning.load(std::memory_order_relaxed)) {
+        ioJitterCycles.store(0, std::memory_order_relaxed);
+        ioJitterSumUs.store(0, std::memory_order_relaxed);
+        ioJitterMaxUs.store(0, std::memory_order_relaxed);
+        ioJitterLate.store(0, std::memory_order_relaxed);
+        phaseStart = currentMillis;
+    }
+    if (currentMillis - phaseStart >= IO_JITTER_PHASE_MS) {
+        bool loaded = ioJitterLoad.load(std::memory_order_relaxed);
+        char phase[64] = "idle";
+        if (loaded) {
+            snprintf(phase, sizeof(phase), "network load, %lu UDP packets, %lu TLS connects",
+                     (unsigned long)ioJitterUdpPackets.exchange(0, std::memory_order_relaxed),
+                     (unsigned long)ioJitterTlsConnects.exchange(0, std::memory_order_relaxed));
+        }
+        uint32_t cycles = ioJitterCycles.exchange(0, std::memory_order_relaxed);
+        uint32_t sumUs = ioJitterSumUs.exchange(0, std::memory_order_relaxed);
+        char msg[224];
+        snprintf(msg, sizeof(msg), "I/O jitter (%s): %lu cycles of %d ms, mean %lu us, max %lu us, %lu late; loop blocked up to %lu ms",
+                 phase, (unsigned long)cycles, IO_TASK_PERIOD_MS, (unsigned long)(cycles ? sumUs / cycles : 0),
+                 (unsigned long)ioJitterMaxUs.exchange(0, std::memory_order_relaxed),
+                 (unsigned long)ioJitterLate.exchange(0, std::memory_order_relaxed), maxLoopGap);
+        Serial.println(msg);
+        publishGeneralLog(msg, "info");
+        ioJitterLoad.store(!loaded, std::memory_order_relaxed);
+        maxLoopGap = 0;
+        phaseStart = currentMillis;
+    }
+}
+
+// ===== Metrics =====
+
+// printf-style append at pos; stops at the end of the buffer (which stays NUL-terminated)
+void appendMetric(char* buf, size_t size, size_t& pos, const char* fmt, ...) {
+    if (pos >= size - 1) return;
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(buf + pos, size - pos, fmt, args);
+    va_end(args);
+    if (written > 0) pos = min(pos + (size_t)written, size - 1);
+}
+
+// Render every metric in the Prometheus text format. Durations are kept in
+// microseconds and printed as seconds without floating point.
+size_t formatMetrics(char* buf, size_t size) {
+    size_t pos = 0;
+    buf[0] = '\0';
+    for (int i = 0; i < numMetricHistograms; i++) {
+        const MetricHistogram& metric = metricHistograms[i];
+        usf_hist_t hist;
+        if (!usf_hist_read(metric.hist, &hist)) continue; // Writer mid-update; the next scrape has it
+        appendMetric(buf, size, pos, "# HELP %s %s\n# TYPE %s histogram\n", metric.name, metric.help, metric.name);
+        uint64_t cumulative = 0;
+        for (int b = 0; b < USF_HIST_BOUNDS; b++) {
+            uint32_t bound = usf_hist_bound_us(b);
+            cumulative += hist.buckets[b];
+            appendMetric(buf, size, pos, "%s_bucket{le=\"%lu.%06lu\"} %llu\n", metric.name,
+                         (unsigned long)(bound / 1000000), (unsigned long)(bound % 1000000), (unsigned long long)cumulative);
+        }
+        cumulative += hist.buckets[USF_HIST_BOUNDS];
+        appendMetric(buf, size, pos, "%s_bucket{le=\"+Inf\"} %llu\n%s_sum %llu.%06lu\n%s_count %llu\n",
+                     metric.name, (unsigned long long)cumulative, metric.name,
+                     (unsigned long long)(hist.sum_us / 1000000), (unsigned long)(hist.sum_us % 1000000),
+                     metric.name, (unsigned long long)cumulative);
+    }
+
+    appendMetric(buf, size, pos, "# TYPE usf_uptime_seconds counter\nusf_uptime_seconds %lu\n", halMillis() / 1000);
+    appendMetric(buf, size, pos, "# TYPE usf_heap_free_bytes gauge\nusf_heap_free_bytes %lu\n", (unsigned long)ESP.getFreeHeap());
+    appendMetric(buf, size, pos, "# TYPE usf_heap_min_free_bytes gauge\nusf_heap_min_free_bytes %lu\n", (unsigned long)ESP.getMinFreeHeap());
+    appendMetric(buf, size, pos, "# TYPE usf_heap_largest_free_block_bytes gauge\nusf_heap_largest_free_block_bytes %lu\n",
+                 (unsigned long)ESP.getMaxAllocHeap());
+    appendMetric(buf, size, pos, "# HELP usf_stack_min_free_bytes Stack high water mark per task\n# TYPE usf_stack_min_free_bytes gauge\n");
+    appendMetric(buf, size, pos, "usf_stack_min_free_bytes{task=\"loop\"} %lu\nusf_stack_min_free_bytes{task=\"io\"} %lu\n",
+                 (unsigned long)uxTaskGetStackHighWaterMark(arduinoTask), (unsigned long)uxTaskGetStackHighWaterMark(ioTaskHandle));
+    appendMetric(buf, size, pos, "# TYPE usf_wifi_reconnects_total counter\nusf_wifi_reconnects_total %lu\n", (unsigned long)wifiReconnects);
+    appendMetric(buf, size, pos, "# TYPE usf_mqtt_connects_total counter\nusf_mqtt_connects_total %lu\n", (unsigned long)mqttConnects);
+    appendMetric(buf, size, pos, "# TYPE usf_mqtt_connect_failures_total counter\nusf_mqtt_connect_failures_total %lu\n",
+                 (unsigned long)mqttConnectFailures);
+    appendMetric(buf, size, pos, "# TYPE usf_publish_queue_depth gauge\nusf_publish_queue_depth %lu\n", (unsigned long)publishQueueCount);
+    appendMetric(buf, size, pos, "# TYPE usf_publish_dropped_total counter\nusf_publish_dropped_total %lu\n", publishDropped);
+    appendMetric(buf, size, pos, "# TYPE usf_event_log_dropped_total counter\nusf_event_log_dropped_total %lu\n",
+                 (unsigned long)eventLogDropped);
+    appendMetric(buf, size, pos, "# HELP usf_io_queue_full_total Pushes refused by a full I/O ring\n# TYPE usf_io_queue_full_total counter\n");
+    appendMetric(buf, size, pos, "usf_io_queue_full_total{queue=\"command\"} %lu\nusf_io_queue_full_total{queue=\"espnow\"} %lu\n"
+                 "usf_io_queue_full_total{queue=\"event\"} %lu\n",
+                 (unsigned long)ioCommands.full.load(std::memory_order_relaxed),
+                 (unsigned long)espNowCommands.full.load(std::memory_order_relaxed),
+                 (unsigned long)ioEvents.full.load(std::memory_order_relaxed));
+    return pos;
+}
+
+// Prometheus scrape endpoint
+void handleMetrics() {
+    if (!isAuthenticated()) {
+        server.send(401, "text/plain", "Unauthorized");
+        return;
+    }
+    size_t len = formatMetrics(statusJson, sizeof(statusJson));
+    server.setContentLength(len);
+    server.send(200, "text/plain; version=0.0.4", "");
+    server.sendContent(statusJson, len);
+}
+
+// Publish the compact snapshot: gauges, counters and [count, p50 us, p99 us] per
+// histogram since the last publish. Sent directly: a stale snapshot is not worth queueing.
+void publishMetrics() {
+    if (!mqttClient.connected()) return;
+    char payload[METRICS_PAYLOAD_SIZE];
+    JsonWriter json(payload, sizeof(payload));
+    json.add("dev", "motor");
+    json.add("up", halMillis() / 1000);
+    json.add("heap", (unsigned long)ESP.getFreeHeap());
+    json.add("minHeap", (unsigned long)ESP.getMinFreeHeap());
+    json.add("block", (unsigned long)ESP.getMaxAllocHeap());
+    char item[36];
+    if (json.beginArray("stack")) {
+        size_t len = snprintf(item, sizeof(item), "%lu,%lu", (unsigned long)uxTaskGetStackHighWaterMark(arduinoTask),
+                              (unsigned long)uxTaskGetStackHighWaterMark(ioTaskHandle));
+        json.appendElement(item, len);
+        json.endArray();
+    }
+    json.add("wifi", (unsigned long)wifiReconnects);
+    json.add("mqtt", (unsigned long)mqttConnects);
+    json.add("queue", (unsigned long)publishQueueCount);
+    json.add("drop", publishDropped);
+    for (int i = 0; i < numMetricHistograms; i++) {
+        uint32_t p50, p99;
+        uint32_t count = usf_hist_interval(metricHistograms[i].hist, &metricsPublished[i], &p50, &p99);
+        if (json.beginArray(metricHistograms[i].shortName)) {
+            size_t len = snprintf(item, sizeof(item), "%lu,%lu,%lu", (unsigned long)count, (unsigned long)p50, (unsigned long)p99);
+            json.appendElement(item, len);
+            json.endArray();
+        }
     }
+    size_t len = json.finish();
+    unsigned long start = halMicros();
+    mqttClient.publish(USF_METRICS_TOPIC, (const uint8_t*)payload, len);
+    usf_hist_observe(&publishHist, halMicros() - start);
 }
 
 // Initialize alert system
 void initializeAlertSystem() {
-    redAlertState = {"", 0, 0, false, 0};
-    amberAlertState = {"", 0, 0, false, 0};
-    greenAlertState = {"", 0, 0, false, 0};
+    redAlertState = {ALARM_NONE, 0, 0, false, 0};
+    amberAlertState = {ALARM_NONE, 0, 0, false, 0};
+    greenAlertState = {ALARM_NONE, 0, 0, false, 0};
 }
 
 // Helper function to manage alert state changes
-bool shouldPublishAlert(AlertState &state, String newMessage, unsigned long currentMillis) {
-    // If message changed, reset stable count
-    if (newMessage != state.message) {
-        state.message = newMessage;
+bool shouldPublishAlert(AlertState &state, AlarmCode newCode, unsigned long currentMillis) {
+    // If alarm changed, reset stable count
+    if (newCode != state.code) {
+        state.code = newCode;
         state.lastChangeTime = currentMillis;
         state.stableCount = 0;
+        state.isActive = false;
+        return false;
+    }
+
+    // Already published this alarm
+    if (state.isActive) {
         return false;
     }
     
@@ -1356,8 +2972,9 @@ bool shouldPublishAlert(AlertState &state, String newMessage, unsigned long curr
         // Only publish if state is stable and cooldown period has passed
         if (state.stableCount >= 2 && 
             currentMillis - state.lastPublishTime >= ALERT_COOLDOWN &&
-            newMessage != "") {
+            newCode != ALARM_NONE) {
             state.lastPublishTime = currentMillis;
+            state.isActive = true;
             return true;
         }
     }
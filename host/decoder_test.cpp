@@ -0,0 +1,212 @@
+// decoder_test.cpp - decodeLEDPattern() against the original if/else chains
+//
+// legacyDecode() is processLEDStatus() from before the table-driven decoder,
+// reduced to its decisions: the alarm codes it chose and the stop/email calls
+// it made. Every one of the 2^16 patterns must decode the same way. Also
+// reports ns per decode for both, and checks that an LED change reported to
+// the loop (reportLEDStatus) does not touch the heap.
+
+#include "MotorESP32S3.cpp"
+#include "sim.h"
+
+#include <chrono>
+#include <string>
+
+struct LegacyDecode {
+    std::string red, green, amber;
+    bool stopUp, stopDown, email;
+};
+
+static LegacyDecode legacyDecode(uint16_t pattern) {
+    auto bit = [pattern](int shift, int i) { return ((pattern >> (shift + i)) & 1) != 0; };
+    bool r0 = bit(LED_RED_SHIFT, 0), r1 = bit(LED_RED_SHIFT, 1), r2 = bit(LED_RED_SHIFT, 2), r3 = bit(LED_RED_SHIFT, 3);
+    bool g0 = bit(LED_GREEN_SHIFT, 0), g1 = bit(LED_GREEN_SHIFT, 1), g2 = bit(LED_GREEN_SHIFT, 2), g3 = bit(LED_GREEN_SHIFT, 3);
+    bool r0f = bit(LED_RED_FLASH_SHIFT, 0), r1f = bit(LED_RED_FLASH_SHIFT, 1);
+    bool r2f = bit(LED_RED_FLASH_SHIFT, 2), r3f = bit(LED_RED_FLASH_SHIFT, 3);
+    bool g0f = bit(LED_GREEN_FLASH_SHIFT, 0), g1f = bit(LED_GREEN_FLASH_SHIFT, 1);
+    bool g2f = bit(LED_GREEN_FLASH_SHIFT, 2), g3f = bit(LED_GREEN_FLASH_SHIFT, 3);
+
+    bool a0 = r0 && g0, a1 = r1 && g1, a2 = r2 && g2, a3 = r3 && g3;
+    bool a0f = (r0f && g0f) || (r0f && g0) || (r0 && g0f);
+    bool a1f = (r1f && g1f) || (r1f && g1) || (r1 && g1f);
+    bool a2f = (r2f && g2f) || (r2f && g2) || (r2 && g2f);
+    bool a3f = (r3f && g3f) || (r3f && g3) || (r3 && g3f);
+
+    bool anyGreenOn = g0 || g1 || g2 || g3;
+    bool anyRedFlashing = r0f || r1f || r2f || r3f;
+    bool anyAmberFlashing = a0f || a1f || a2f || a3f;
+
+    LegacyDecode out = {"", "", "", false, false, false};
+    auto stopBoth = [&out]() { out.stopUp = out.stopDown = true; };
+
+    if (!anyGreenOn && !anyAmberFlashing) {
+        std::string alertName = "";
+        if (!r0 && !r1 && !r2 && !r3) {
+            alertName = "R01";
+        } else if (r0 && r1 && r2 && r3) {
+            alertName = "R02"; stopBoth();
+        } else if (r0 && r1 && r2 && !r3) {
+            alertName = "R15"; stopBoth();
+        } else if (r0 && r1 && !r2 && !r3) {
+            alertName = "R23"; stopBoth();
+        } else if (!r0 && !r1 && r2 && r3) {
+            alertName = "R22"; stopBoth();
+        }
+        if (!r0f && !r1f && !r2f && !r3f) {
+            alertName = "R00"; stopBoth();
+        } else if (!r0f && r1f && !r2f && !r3f) {
+            alertName = "R31"; stopBoth();
+        } else if (!r0f && r1f && r2f && r3f) {
+            alertName = "R36"; stopBoth();
+        } else if (r0f && !r1f && !r2f && !r3f) {
+            alertName = "R37"; stopBoth();
+        } else if (!r0f && r1f && !r2f && r3f) {
+            alertName = "R07"; stopBoth();
+        } else if (r0f && r1f && r2f && r3f) {
+            alertName = "R03"; stopBoth();
+        } else if (r0f && !r1f && !r2f && r3f) {
+            alertName = "R27"; stopBoth();
+        } else if (r0f && r1f && r2f && !r3f) {
+            alertName = "R10"; stopBoth();
+        } else if (!r0f && !r1f && r2f && !r3f) {
+            alertName = "R11"; stopBoth();
+        } else if (!r0f && r1f && r2f && !r3f) {
+            alertName = "R12"; stopBoth();
+        } else if (r0f && !r1f && r2f && !r3f) {
+            alertName = "R13"; stopBoth();
+        } else if (!r0f && !r1f && r2f && r3f) {
+            alertName = "R24"; stopBoth();
+        } else if (!r0f && !r1f && !r2f && r3f) {
+            alertName = "R05"; stopBoth();
+        }
+        if (alertName != "") {
+            out.red = alertName;
+            out.email = true;
+        }
+    }
+
+    if (!anyRedFlashing) {
+        if (!g0 && !g1 && !g2 && !g3) {
+            out.green = "G01";
+        } else if (g0 && g1 && g2 && g3) {
+            out.green = "G00";
+        } else if (!g0f && !g1f && !g2f && !g3f) {
+            out.green = "G02";
+        } else if (g0f && g1f && g2f && !g3f) {
+            out.green = "G03";
+        } else if (g0f && g1f && g2f && g3f) {
+            out.green = "G04";
+        }
+    }
+
+    std::string alertName = "";
+    if (!a0 && !a1 && !a2 && !a3) {
+        alertName = "A01";
+    } else if (a0 && a1 && a2 && !a3) {
+        alertName = "A04";
+    } else if (!a0 && a1 && a2 && a3) {
+        alertName = "A39";
+    } else if (a0 && !a1 && !a2 && !a3) {
+        alertName = "A30";
+    } else if (!a0 && a1 && !a2 && !a3) {
+        alertName = "A33";
+    } else if (a0 && a1 && !a2 && !a3) {
+        alertName = "A34";
+    } else if (!a0 && !a1 && a2 && !a3) {
+        alertName = "A35";
+    } else if (!a0 && !a1 && a2 && a3) {
+        alertName = "A36";
+    } else if (a0 && !a1 && !a2 && a3) {
+        alertName = "A37";
+    }
+    if (!a0f && !a1f && !a2f && !a3f) {
+        alertName = "A02";
+    } else if (a0f && a1f && a2f && !a3f) {
+        alertName = "A32"; out.stopUp = true;
+    } else if (!a0f && a1f && a2f && a3f) {
+        alertName = "A40";
+    } else if (!a0f && !a1f && a2f && !a3f) {
+        alertName = "A06"; out.stopUp = true;
+    } else if (a0f && !a1f && !a2f && a3f) {
+        alertName = "A08"; out.stopUp = true;
+    } else if (a0f && a1f && !a2f && !a3f) {
+        alertName = "A14"; out.stopDown = true;
+    } else if (!a0f && a1f && !a2f && !a3f) {
+        alertName = "A16"; out.stopDown = true;
+    } else if (!a0f && a1f && a2f && !a3f) {
+        alertName = "A38";
+    }
+    out.amber = alertName;
+    return out;
+}
+
+static int checkEquivalence() {
+    int mismatches = 0;
+    for (uint32_t pattern = 0; pattern <= 0xFFFF; pattern++) {
+        LegacyDecode expected = legacyDecode((uint16_t)pattern);
+        AlarmDecode actual = decodeLEDPattern((uint16_t)pattern);
+        bool same = expected.red == alarmTable[actual.red].code && expected.green == alarmTable[actual.green].code &&
+                    expected.amber == alarmTable[actual.amber].code &&
+                    expected.stopUp == ((actual.actions & ALARM_ACTION_STOP_UP) != 0) &&
+                    expected.stopDown == ((actual.actions & ALARM_ACTION_STOP_DOWN) != 0) &&
+                    expected.email == ((actual.actions & ALARM_ACTION_EMAIL) != 0);
+        if (!same && mismatches++ < 10) {
+            printf("  pattern 0x%04x: legacy %s/%s/%s up%d down%d email%d, table %s/%s/%s actions 0x%02x\n", pattern,
+                   expected.red.c_str(), expected.green.c_str(), expected.amber.c_str(), expected.stopUp,
+                   expected.stopDown, expected.email, alarmTable[actual.red].code, alarmTable[actual.green].code,
+                   alarmTable[actual.amber].code, actual.actions);
+        }
+    }
+    printf("equivalence: 65536 patterns, %d mismatches\n", mismatches);
+    return mismatches;
+}
+
+template <typename Decode>
+static double nsPerDecode(int passes, Decode decode) {
+    unsigned sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        for (uint32_t pattern = 0; pattern <= 0xFFFF; pattern++) sink += decode((uint16_t)pattern);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (sink == 1) printf(" "); // Keeps the loop from being optimised away
+    return ns / (passes * 65536.0);
+}
+
+// Heap allocations made by the loop for LED changes (reportLEDStatus -> processLEDStatus)
+static int checkChangePathAllocations() {
+    simBoot();
+    simRun(2000 * 1000);
+    IoEvent event = {};
+    event.type = IO_EVT_LED;
+    simHeapReset();
+    const int changes = 4096;
+    for (int i = 0; i < changes; i++) {
+        event.ledPattern = (uint16_t)(i * 40503u); // Walks all bit positions
+        SimFirmwareScope scope;
+        reportLEDStatus(event);
+        lastLEDStatusLog -= LED_STATUS_LOG_INTERVAL; // Take the debug-log branch every time
+    }
+    SimHeapStats heap = simHeap();
+    printf("change path: %d LED changes, %llu heap allocations (%llu B)\n", changes,
+           (unsigned long long)heap.allocs, (unsigned long long)heap.allocBytes);
+    return heap.allocs == 0 ? 0 : 1;
+}
+
+int main() {
+    int failures = checkEquivalence();
+
+    double legacyNs = nsPerDecode(5, [](uint16_t pattern) {
+        LegacyDecode decode = legacyDecode(pattern);
+        return (unsigned)decode.red.size() + decode.amber[1] + decode.stopUp;
+    });
+    double tableNs = nsPerDecode(200, [](uint16_t pattern) {
+        AlarmDecode decode = decodeLEDPattern(pattern);
+        return (unsigned)decode.red + decode.amber + decode.actions;
+    });
+    printf("decode: legacy chains %.1f ns, tables %.1f ns per pattern (host CPU)\n", legacyNs, tableNs);
+
+    failures += checkChangePathAllocations();
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,164 @@
+// event_log_test.cpp - SPIFFS event log: page index, reboots and queries
+//
+// Runs the log functions directly on the simulated SPIFFS. A "reboot" drops the
+// RAM state (pending records included, as a power cut would) and runs
+// initEventLog() on the file left behind.
+
+#include "MotorESP32S3.cpp"
+#include "sim.h"
+
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-60s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static void reboot() {
+    SimFirmwareScope scope;
+    eventLogNewestSeq = 0;
+    eventLogFlushedSeq = 0;
+    eventLogWritePageColours = 0;
+    initEventLog();
+}
+
+static void freshLog() {
+    SPIFFS.remove(EVENT_LOG_FILE);
+    reboot();
+}
+
+static void append(int count, AlarmCode alarm) {
+    SimFirmwareScope scope;
+    for (int i = 0; i < count; i++) logEvent(alarm == ALARM_NONE ? EVENT_LED_CHANGE : EVENT_ALARM, alarm, 0);
+}
+
+// Every record matching colourMask, paging through queryEvents() like a client
+static std::vector<uint32_t> queryAll(uint8_t colourMask) {
+    std::vector<uint32_t> seqs;
+    EventRecord records[EVENT_QUERY_MAX_LIMIT];
+    uint32_t since = 0;
+    for (;;) {
+        uint32_t found;
+        uint32_t last;
+        {
+            SimFirmwareScope scope;
+            last = queryEvents(since, EVENT_QUERY_MAX_LIMIT, colourMask, records, found);
+        }
+        for (uint32_t i = 0; i < found; i++) seqs.push_back(records[i].seq);
+        if (last == since || last >= eventLogNewestSeq) break;
+        since = last;
+    }
+    return seqs;
+}
+
+static void rebootMidPage() {
+    printf("reboot in the middle of an index page\n");
+    freshLog();
+    append(10, ALARM_R10);   // seq 1-10: red, first page
+    append(90, ALARM_NONE);
+    flushEventLog();
+    reboot();
+    check(eventLogNewestSeq == 100, "newest seq recovered");
+    append(EVENT_LOG_PAGE_SIZE - 100, ALARM_NONE);  // Completes page 0 after the reboot
+    flushEventLog();
+    check(eventLogPageColours[0] & ALARM_COLOUR_RED, "page 0 still indexed as red");
+    check(queryAll(ALARM_COLOUR_RED).size() == 10, "red query finds the 10 records from before the reboot");
+}
+
+static void rebootOnSecondLap() {
+    printf("reboot mid-page on the second lap\n");
+    freshLog();
+    append(EVENT_LOG_PAGE_SIZE, ALARM_A14);          // Page 0, first lap: amber
+    append(EVENT_LOG_CAPACITY - EVENT_LOG_PAGE_SIZE, ALARM_NONE);
+    append(5, ALARM_R02);                            // Page 0, second lap: red, overwriting amber
+    append(20, ALARM_NONE);
+    flushEventLog();
+    reboot();
+    append(EVENT_LOG_PAGE_SIZE - 25, ALARM_NONE);
+    flushEventLog();
+    check(eventLogPageColours[0] == ALARM_COLOUR_RED, "page 0 index exact after the lap: red, no amber");
+    check(queryAll(ALARM_COLOUR_RED).size() == 5, "red query finds the 5 second-lap records");
+    check(queryAll(ALARM_COLOUR_AMBER).empty(), "overwritten amber records are gone");
+}
+
+static bool seqsAre(const std::vector<uint32_t>& seqs, uint32_t first, uint32_t last) {
+    if (seqs.size() != last - first + 1) return false;
+    for (size_t i = 0; i < seqs.size(); i++) {
+        if (seqs[i] != first + i) return false;
+    }
+    return true;
+}
+
+static void failedFlushRetried() {
+    printf("flash write fails, then recovers\n");
+    freshLog();
+    append(5, ALARM_NONE);
+    flushEventLog();
+    simFlashFailWrites = true;
+    append(10, ALARM_R02);
+    flushEventLog();
+    check(eventLogFlushedSeq == 5, "failed flush keeps the records pending");
+    simFlashFailWrites = false;
+    flushEventLog();
+    check(eventLogFlushedSeq == 15, "next flush writes them");
+    check(seqsAre(queryAll(0), 1, 15), "all 15 records readable, in order");
+    reboot();
+    check(seqsAre(queryAll(ALARM_COLOUR_RED), 6, 15), "and still there after a reboot");
+}
+
+// 1-10 from flash, then 19-50 after the 8 dropped records
+static bool seqsAroundGap(const std::vector<uint32_t>& seqs) {
+    return seqs.size() == 10 + 32 && seqsAre(std::vector<uint32_t>(seqs.begin(), seqs.begin() + 10), 1, 10) &&
+           seqsAre(std::vector<uint32_t>(seqs.begin() + 10, seqs.end()), 19, 50);
+}
+
+static void outageDropsOldest() {
+    printf("flash refuses writes for longer than the RAM batch lasts\n");
+    freshLog();
+    uint32_t droppedBefore = eventLogDropped;
+    append(10, ALARM_NONE);
+    flushEventLog();
+    simFlashFailWrites = true;
+    append(EVENT_LOG_PENDING_SIZE + 8, ALARM_R02);  // seq 11-50, the oldest 8 cannot be kept
+    check(eventLogDropped - droppedBefore == 8, "8 oldest records dropped and counted");
+    check(seqsAroundGap(queryAll(0)), "query skips the gap, newest 32 served from RAM");
+    simFlashFailWrites = false;
+    flushEventLog();
+    File file = SPIFFS.open(EVENT_LOG_FILE, FILE_READ);
+    check(file && file.size() == 50 * sizeof(EventRecord), "gap padded with empty slots, no seek past the end");
+    if (file) file.close();
+    check(seqsAroundGap(queryAll(0)), "same query once written");
+    reboot();
+    check(eventLogNewestSeq == 50 && seqsAroundGap(queryAll(0)), "and after a reboot");
+    append(1, ALARM_NONE);
+    check(eventLogNewestSeq == 51, "numbering continues after the gap");
+}
+
+static void flashFull() {
+    printf("flash full in the middle of a batch\n");
+    freshLog();
+    size_t freeBefore = simFlashFree;
+    simFlashFree = 20 * sizeof(EventRecord) + 5;  // Room for 20 records and part of one more
+    append(EVENT_LOG_PENDING_SIZE, ALARM_NONE);   // Fills the RAM batch without flushing
+    flushEventLog();
+    check(eventLogFlushedSeq == 20, "short write keeps the 20 whole records");
+    simFlashFree = freeBefore;
+    flushEventLog();
+    check(seqsAre(queryAll(0), 1, EVENT_LOG_PENDING_SIZE), "the rest follow once there is room");
+}
+
+int main() {
+    {
+        SimFirmwareScope scope;
+        SPIFFS.begin(true);
+    }
+    rebootMidPage();
+    rebootOnSecondLap();
+    failedFlushRetried();
+    outageDropsOldest();
+    flashFull();
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+// events_http_test.cpp - GET /events through the web server, and a 100k record benchmark
+//
+// The request goes through the routes and collected headers set up by setup()
+// and is served by server.handleClient() from loop(), so the test fails if
+// either is missing. The benchmark appends 100000 records (three laps of the
+// 32768 slot file), then pages through it. Host times only compare runs on the
+// same machine; the flash bytes read show what the page index saves.
+
+#include "MotorESP32S3.cpp"
+#include "sim.h"
+
+#include <chrono>
+#include <string>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-60s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static const SimResponse& get(const std::string& url, bool loggedIn) {
+    std::map<std::string, std::string> headers;
+    if (loggedIn) headers["Cookie"] = "SESSIONID=1";
+    uint32_t served = server.requestsServed;
+    server.simRequest(url, headers);
+    while (server.requestsServed == served) simRun(1000);
+    return server.lastResponse;
+}
+
+static void reachable() {
+    printf("GET /events\n");
+    {
+        SimFirmwareScope scope;
+        logEvent(EVENT_ALARM, ALARM_R10, 0x0700);
+        logEvent(EVENT_ALARM, ALARM_A14, 0x0333);
+    }
+    const SimResponse& denied = get("/events", false);
+    check(denied.code == 401, "no session cookie: 401");
+    const SimResponse& all = get("/events?since=0&limit=50", true);
+    check(all.code == 200 && all.contentType == "application/json", "session cookie: 200 application/json");
+    check(all.body.find("\"code\":\"R10\"") != std::string::npos && all.body.find("\"code\":\"A14\"") != std::string::npos,
+          "both alarms listed");
+    const SimResponse& red = get("/events?colour=red", true);
+    check(red.body.find("R10") != std::string::npos && red.body.find("A14") == std::string::npos,
+          "colour=red filters out the amber alarm");
+    const SimResponse& both = get("/events?colour=amber,red", true);
+    check(both.body.find("R10") != std::string::npos && both.body.find("A14") != std::string::npos,
+          "colour=amber,red lists both");
+
+    const char* badQueries[] = {"limit=0", "limit=-5", "limit=abc", "limit=", "limit=10x",
+                                "colour=purple", "colour=red,purple", "colour=", "colour=reddish"};
+    bool allRejected = true;
+    for (const char* query : badQueries) {
+        if (get(std::string("/events?") + query, true).code != 400) {
+            printf("  %s was not rejected\n", query);
+            allRejected = false;
+        }
+    }
+    check(allRejected, "bad limit or unknown colour: 400");
+    const SimResponse& capped = get("/events?limit=5000", true);
+    check(capped.code == 200, "limit above the maximum is capped, not refused");
+}
+
+static double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void benchmark() {
+    const uint32_t records = 100000;
+    printf("benchmark: %lu records\n", (unsigned long)records);
+    uint32_t writesBefore = simFlashWrites;
+    auto start = std::chrono::steady_clock::now();
+    {
+        SimFirmwareScope scope;
+        for (uint32_t i = 0; i < records; i++) {
+            // One red alarm per 1000 records, the rest LED changes
+            if (i % 1000 == 0) logEvent(EVENT_ALARM, ALARM_R02, 0x000F);
+            else logEvent(EVENT_LED_CHANGE, ALARM_NONE, (uint16_t)i);
+        }
+        flushEventLog();
+    }
+    double appendMs = msSince(start);
+    printf("  append   %8.0f ns/record, %.1f records per flash write\n", appendMs * 1e6 / records,
+           (double)records / (simFlashWrites - writesBefore));
+
+    const struct { const char* name; uint8_t mask; } queries[] = {
+        {"all records", 0},
+        {"red only (sparse)", ALARM_COLOUR_RED},
+        {"green only (none)", ALARM_COLOUR_GREEN},
+    };
+    static EventRecord results[EVENT_QUERY_MAX_LIMIT];
+    for (const auto& query : queries) {
+        start = std::chrono::steady_clock::now();
+        uint64_t readBefore = simFlashReadBytes;
+        uint32_t since = 0, pages = 0, total = 0;
+        SimFirmwareScope scope;
+        for (;;) {
+            uint32_t found;
+            uint32_t last = queryEvents(since, EVENT_QUERY_MAX_LIMIT, query.mask, results, found);
+            pages++;
+            total += found;
+            if (last == since || last >= eventLogNewestSeq) break;
+            since = last;
+        }
+        double ms = msSince(start);
+        printf("  query %-18s %6lu records in %3lu pages, %4lu KB read from flash, %7.3f ms\n", query.name,
+               (unsigned long)total, (unsigned long)pages, (unsigned long)((simFlashReadBytes - readBefore) / 1024), ms);
+    }
+    check(eventLogNewestSeq - eventLogOldestSeq() + 1 == EVENT_LOG_CAPACITY, "log holds the newest 32768 records");
+}
+
+int main() {
+    simBoot();
+    simRun(2000 * 1000);
+    reachable();
+    benchmark();
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
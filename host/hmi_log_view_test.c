@@ -0,0 +1,164 @@
+// hmi_log_view_test.c - HMI log views with 10k retained entries and a 50 msg/s burst
+//
+// Runs HMIESP32.C's ui_frame() every UI_FRAME_MS of virtual time against the
+// fake LVGL in hmi_shims/ (no real LVGL is available offline, so nothing is
+// rendered). Messages arrive through mqtt_event_handler() like on the board.
+// Reported per frame: host CPU time of ui_frame(), label texts set and objects
+// invalidated (what real LVGL would have to redraw). RAM is the log rings from
+// heap_caps_calloc() plus the fake LVGL's objects and label text copies.
+
+#include "HMIESP32.C"
+#include "hmi_sim.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#define TEST_LOG_ENTRIES 10000
+#define TEST_RATE_PER_S 50
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("  %-60s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static uint64_t host_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// One message as the motor or dashboard publishes it; every fifth is a red alarm
+static void deliver(uint32_t n) {
+    char payload[160];
+    bool alarm = n % 5 == 0;
+    int len = snprintf(payload, sizeof(payload),
+                       "{\"type\":\"%s\",\"message\":\"%s %lu\",\"timestamp\":\"2026-10-17 12:00:00\"}",
+                       alarm ? "red" : "info", alarm ? "R10 - Overload" : "Motor current nominal", (unsigned long)n);
+    hmi_sim_mqtt_deliver(alarm ? "usf/logs/alerts" : MQTT_TOPIC, payload, len, 0);
+}
+
+typedef struct {
+    uint64_t frames;
+    uint64_t ns[100000];
+    uint64_t label_sets;
+    uint64_t max_label_sets;
+    uint64_t invalidations;
+    uint64_t max_invalidations;
+} frame_stats_t;
+
+static void run_frames(frame_stats_t *stats, uint32_t seconds, uint32_t *sent) {
+    uint32_t frames = seconds * 1000 / UI_FRAME_MS;
+    uint32_t per_message_ms = 1000 / TEST_RATE_PER_S;
+    memset(stats, 0, sizeof(*stats));
+    for (uint32_t f = 0; f < frames; f++) {
+        if ((f * UI_FRAME_MS) % per_message_ms == 0) deliver((*sent)++);
+        hmi_sim_lvgl_t before = hmi_sim_lvgl();
+        uint64_t start = host_ns();
+        ui_frame();
+        stats->ns[stats->frames++] = host_ns() - start;
+        hmi_sim_lvgl_t after = hmi_sim_lvgl();
+        uint64_t sets = after.label_sets - before.label_sets;
+        uint64_t invalid = after.invalidations - before.invalidations;
+        stats->label_sets += sets;
+        stats->invalidations += invalid;
+        if (sets > stats->max_label_sets) stats->max_label_sets = sets;
+        if (invalid > stats->max_invalidations) stats->max_invalidations = invalid;
+        hmi_sim_advance_us(UI_FRAME_MS * 1000);
+    }
+}
+
+static void print_stats(const char *name, frame_stats_t *stats) {
+    qsort(stats->ns, stats->frames, sizeof(uint64_t), compare_u64);
+    printf("  %-22s frame %5.1f us p50, %5.1f us p99, %5.1f us max; labels set %.1f/frame (max %llu), "
+           "objects redrawn %.1f/frame (max %llu)\n",
+           name, stats->ns[stats->frames / 2] / 1000.0, stats->ns[stats->frames * 99 / 100] / 1000.0,
+           stats->ns[stats->frames - 1] / 1000.0, (double)stats->label_sets / stats->frames,
+           (unsigned long long)stats->max_label_sets, (double)stats->invalidations / stats->frames,
+           (unsigned long long)stats->max_invalidations);
+}
+
+static const char *newest_row(const log_view_t *view) {
+    for (int i = view->row_count - 1; i >= 0; i--) {
+        if (!hmi_sim_hidden(view->rows[i])) return hmi_sim_label_text(view->rows[i]);
+    }
+    return "";
+}
+
+static bool contains_number(const char *text, uint32_t n) {
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), " %lu", (unsigned long)n);
+    size_t len = strlen(text), suffix_len = strlen(suffix);
+    return len >= suffix_len && strcmp(text + len - suffix_len, suffix) == 0;
+}
+
+static frame_stats_t stats;
+
+int main(void) {
+    ui_queue = xQueueCreate(UI_QUEUE_LEN, sizeof(ui_msg_t));
+    log_ring_init(&log_ring, TEST_LOG_ENTRIES);
+    log_ring_init(&alert_ring, ALERT_RING_ENTRIES);
+    ui_init();
+    mqtt_start();
+    ui_frame();
+    uint32_t sent = 1;
+
+    printf("filling the terminal ring to %d entries\n", TEST_LOG_ENTRIES);
+    while (log_ring.total < TEST_LOG_ENTRIES + 100) {
+        for (int i = 0; i < UI_QUEUE_LEN / 2; i++) deliver(sent++);
+        ui_frame();
+    }
+    hmi_sim_heap_t heap = hmi_sim_heap();
+    hmi_sim_lvgl_t lvgl = hmi_sim_lvgl();
+    printf("  RAM: rings %zu KB PSRAM + %zu KB internal (%zu B per entry), UI queue %zu KB, "
+           "%llu LVGL objects, %llu B of label text\n",
+           heap.psram / 1024, heap.internal / 1024, sizeof(log_entry_t), UI_QUEUE_LEN * sizeof(ui_msg_t) / 1024,
+           (unsigned long long)lvgl.objects, (unsigned long long)lvgl.text_bytes);
+    printf("  shipped sizes (%d + %d entries): %zu KB PSRAM\n", LOG_RING_ENTRIES, ALERT_RING_ENTRIES,
+           (LOG_RING_ENTRIES + ALERT_RING_ENTRIES) * sizeof(log_entry_t) / 1024);
+    check(log_ring.capacity == TEST_LOG_ENTRIES && log_ring_oldest(&log_ring) == log_ring.total - TEST_LOG_ENTRIES,
+          "ring keeps the newest 10000 entries");
+    check(lvgl.objects < 100, "LVGL objects do not grow with the entries kept");
+
+    printf("%d msg/s for 60 s, following the newest line\n", TEST_RATE_PER_S);
+    uint32_t dropped = ui_dropped;
+    run_frames(&stats, 60, &sent);
+    print_stats("following", &stats);
+    check(ui_dropped == dropped, "no record dropped");
+    check(contains_number(newest_row(&terminal_view), sent - 1), "last row shows the newest message");
+    check(stats.max_label_sets <= (uint64_t)2 * LOG_VIEW_MAX_ROWS, "a frame sets at most one window of rows per view");
+
+    printf("burst: %d messages between two frames\n", TEST_RATE_PER_S);
+    dropped = ui_dropped;
+    uint32_t alerts_before = alert_ring.total;
+    for (int i = 0; i < TEST_RATE_PER_S; i++) deliver(sent++);
+    ui_frame();
+    ui_frame();
+    check(ui_dropped == dropped, "queue absorbs the burst, nothing dropped");
+    check(alert_ring.total - alerts_before == TEST_RATE_PER_S / 5, "every alarm reached the alert ring");
+    check(contains_number(newest_row(&terminal_view), sent - 1), "and the view caught up with it");
+
+    printf("scrolled back while messages keep arriving\n");
+    hmi_sim_drag(terminal_view.box, 20 * LOG_ROW_HEIGHT);
+    ui_frame();
+    uint32_t top = terminal_view.top;
+    uint32_t rendered_total = terminal_view.rendered_total;
+    run_frames(&stats, 10, &sent);
+    print_stats("scrolled back", &stats);
+    check(!terminal_view.follow && terminal_view.top == top, "window stays where the user left it");
+    // The alert view still follows, so only its rows show up in the counts above
+    check(terminal_view.rendered_total == rendered_total, "terminal rows are not redrawn while scrolled back");
+    for (int i = 0; i < 100 && !terminal_view.follow; i++) hmi_sim_drag(terminal_view.box, -100 * LOG_ROW_HEIGHT);
+    ui_frame();
+    check(terminal_view.follow && contains_number(newest_row(&terminal_view), sent - 1),
+          "dragging back to the end resumes following");
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
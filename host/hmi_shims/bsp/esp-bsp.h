@@ -0,0 +1,14 @@
+// esp-bsp.h - Host shim of the ESP32-S3-LCD-EV-BOARD display functions
+
+#ifndef HMI_HOST_ESP_BSP_H
+#define HMI_HOST_ESP_BSP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void bsp_display_start(void);
+void bsp_display_backlight_on(void);
+bool bsp_display_lock(uint32_t timeout_ms);
+void bsp_display_unlock(void);
+
+#endif // HMI_HOST_ESP_BSP_H
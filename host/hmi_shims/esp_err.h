@@ -0,0 +1,14 @@
+// esp_err.h - Host shim of esp_err_t
+
+#ifndef HMI_HOST_ESP_ERR_H
+#define HMI_HOST_ESP_ERR_H
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERROR_CHECK(x) ((void)(x))
+
+const char *esp_err_to_name(esp_err_t err);
+
+#endif // HMI_HOST_ESP_ERR_H
@@ -0,0 +1,19 @@
+// esp_heap_caps.h - Host shim: allocations are counted per capability (hmi_sim_heap())
+
+#ifndef HMI_HOST_ESP_HEAP_CAPS_H
+#define HMI_HOST_ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h> // The ESP-IDF header pulls it in too; HMIESP32.C relies on that for free()
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps);
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+
+#endif // HMI_HOST_ESP_HEAP_CAPS_H
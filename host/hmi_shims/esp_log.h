@@ -0,0 +1,10 @@
+// esp_log.h - Host shim: ESP-IDF log macros compile to nothing
+
+#ifndef HMI_HOST_ESP_LOG_H
+#define HMI_HOST_ESP_LOG_H
+
+#define ESP_LOGI(tag, ...) ((void)(tag))
+#define ESP_LOGW(tag, ...) ((void)(tag))
+#define ESP_LOGE(tag, ...) ((void)(tag))
+
+#endif // HMI_HOST_ESP_LOG_H
@@ -0,0 +1,13 @@
+// esp_netif.h - Host shim of the network interface setup
+
+#ifndef HMI_HOST_ESP_NETIF_H
+#define HMI_HOST_ESP_NETIF_H
+
+#include "esp_err.h"
+
+typedef struct hmi_sim_netif esp_netif_t;
+
+esp_err_t esp_netif_init(void);
+esp_netif_t *esp_netif_create_default_wifi_sta(void);
+
+#endif // HMI_HOST_ESP_NETIF_H
@@ -0,0 +1,14 @@
+// esp_sntp.h - Host shim (time comes from the host clock)
+
+#ifndef HMI_HOST_ESP_SNTP_H
+#define HMI_HOST_ESP_SNTP_H
+
+#include <time.h>
+
+#define SNTP_OPMODE_POLL 0
+
+void esp_sntp_setoperatingmode(int mode);
+void esp_sntp_setservername(int index, const char *server);
+void esp_sntp_init(void);
+
+#endif // HMI_HOST_ESP_SNTP_H
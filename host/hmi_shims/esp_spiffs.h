@@ -0,0 +1,18 @@
+// esp_spiffs.h - Host shim: mounting SPIFFS always fails (the HMI only logs it)
+
+#ifndef HMI_HOST_ESP_SPIFFS_H
+#define HMI_HOST_ESP_SPIFFS_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef struct {
+    const char *base_path;
+    const char *partition_label;
+    int max_files;
+    bool format_if_mount_failed;
+} esp_vfs_spiffs_conf_t;
+
+esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t *conf);
+
+#endif // HMI_HOST_ESP_SPIFFS_H
@@ -0,0 +1,10 @@
+// esp_timer.h - Host shim: the simulator's virtual clock (hmi_sim_advance_us())
+
+#ifndef HMI_HOST_ESP_TIMER_H
+#define HMI_HOST_ESP_TIMER_H
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
+
+#endif // HMI_HOST_ESP_TIMER_H
@@ -0,0 +1,6 @@
+// esp_tls.h - Host shim (HMIESP32.C includes it but uses nothing from it)
+
+#ifndef HMI_HOST_ESP_TLS_H
+#define HMI_HOST_ESP_TLS_H
+
+#endif // HMI_HOST_ESP_TLS_H
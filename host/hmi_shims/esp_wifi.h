@@ -0,0 +1,49 @@
+// esp_wifi.h - Host shim of the Wi-Fi station API (nothing connects)
+
+#ifndef HMI_HOST_ESP_WIFI_H
+#define HMI_HOST_ESP_WIFI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_event.h"
+
+extern esp_event_base_t WIFI_EVENT;
+extern esp_event_base_t IP_EVENT;
+enum { WIFI_EVENT_STA_START = 2, WIFI_EVENT_STA_DISCONNECTED = 5 };
+enum { IP_EVENT_STA_GOT_IP = 0 };
+
+typedef struct {
+    uint32_t addr;
+} ip_event_got_ip_t;
+
+typedef struct {
+    int unused;
+} wifi_init_config_t;
+#define WIFI_INIT_CONFIG_DEFAULT() {0}
+
+typedef enum { WIFI_AUTH_OPEN = 0, WIFI_AUTH_WPA2_PSK = 3 } wifi_auth_mode_t;
+typedef enum { WIFI_MODE_STA = 1 } wifi_mode_t;
+typedef enum { WIFI_IF_STA = 0 } wifi_interface_t;
+
+typedef struct {
+    struct {
+        char ssid[32];
+        char password[64];
+        struct {
+            wifi_auth_mode_t authmode;
+        } threshold;
+        struct {
+            bool capable;
+            bool required;
+        } pmf_cfg;
+    } sta;
+} wifi_config_t;
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *config);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_connect(void);
+
+#endif // HMI_HOST_ESP_WIFI_H
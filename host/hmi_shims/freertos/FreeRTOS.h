@@ -0,0 +1,24 @@
+// FreeRTOS.h - Host shim of the FreeRTOS types HMIESP32.C uses (see hmi_sim.h)
+
+#ifndef HMI_HOST_FREERTOS_H
+#define HMI_HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+// ESP-IDF's newlib has strlcpy(); glibc before 2.38 does not
+#define strlcpy hmi_sim_strlcpy
+size_t hmi_sim_strlcpy(char *dst, const char *src, size_t size);
+
+#endif // HMI_HOST_FREERTOS_H
@@ -0,0 +1,14 @@
+// queue.h - Host shim: a FreeRTOS queue as a fixed ring of copied items
+
+#ifndef HMI_HOST_QUEUE_H
+#define HMI_HOST_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct hmi_sim_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(unsigned length, unsigned item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait);
+
+#endif // HMI_HOST_QUEUE_H
@@ -0,0 +1,14 @@
+// semphr.h - Host shim: one thread, so mutexes always succeed
+
+#ifndef HMI_HOST_SEMPHR_H
+#define HMI_HOST_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+typedef struct hmi_sim_mutex *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex);
+
+#endif // HMI_HOST_SEMPHR_H
@@ -0,0 +1,16 @@
+// task.h - Host shim: tasks are recorded, never started; vTaskDelay() advances the virtual clock
+
+#ifndef HMI_HOST_TASK_H
+#define HMI_HOST_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct hmi_sim_task *TaskHandle_t;
+
+BaseType_t xTaskCreate(void (*task)(void *), const char *name, uint32_t stack, void *arg, unsigned priority,
+                       TaskHandle_t *handle);
+void vTaskDelay(TickType_t ticks);
+unsigned uxTaskGetStackHighWaterMark(TaskHandle_t task);
+TaskHandle_t xTaskGetHandle(const char *name);
+
+#endif // HMI_HOST_TASK_H
@@ -0,0 +1,105 @@
+// lvgl.h - Fake LVGL 8 for the HMI host build (not the real library)
+//
+// Objects keep only their parent, children, flags, state and label text; nothing
+// is laid out or rendered. Every call that would make real LVGL redraw an object
+// (text, colour, visibility) marks it invalid, and lv_timer_handler() counts and
+// clears those marks. hmi_sim.h reads the counters, so a test can see how much
+// drawing work a frame causes without LVGL or a display.
+
+#ifndef HMI_HOST_LVGL_H
+#define HMI_HOST_LVGL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef int16_t lv_coord_t;
+typedef struct _lv_obj_t lv_obj_t;
+typedef struct _lv_event_t lv_event_t;
+typedef struct _lv_indev_t lv_indev_t;
+typedef void (*lv_event_cb_t)(lv_event_t *e);
+
+typedef struct {
+    uint32_t full;
+} lv_color_t;
+
+typedef struct {
+    lv_coord_t x;
+    lv_coord_t y;
+} lv_point_t;
+
+typedef struct {
+    const char *name;
+} lv_obj_class_t;
+extern const lv_obj_class_t lv_obj_class, lv_label_class, lv_btn_class, lv_switch_class, lv_dropdown_class,
+    lv_tabview_class;
+
+#define LV_HOR_RES 800 // ESP32-S3-LCD-EV-BOARD panel
+#define LV_VER_RES 480
+
+typedef enum { LV_DIR_LEFT = 1, LV_DIR_RIGHT = 2, LV_DIR_TOP = 4, LV_DIR_BOTTOM = 8 } lv_dir_t;
+typedef enum { LV_ANIM_OFF, LV_ANIM_ON } lv_anim_enable_t;
+enum { LV_PART_MAIN = 0 };
+typedef enum {
+    LV_EVENT_PRESSED = 1,
+    LV_EVENT_PRESSING = 2,
+    LV_EVENT_CLICKED = 7,
+    LV_EVENT_RELEASED = 8,
+    LV_EVENT_VALUE_CHANGED = 28,
+} lv_event_code_t;
+enum { LV_STATE_CHECKED = 1 };
+enum { LV_OBJ_FLAG_HIDDEN = 1 << 0, LV_OBJ_FLAG_CLICKABLE = 1 << 1, LV_OBJ_FLAG_SCROLLABLE = 1 << 4 };
+enum {
+    LV_ALIGN_DEFAULT = 0,
+    LV_ALIGN_TOP_LEFT,
+    LV_ALIGN_TOP_MID,
+    LV_ALIGN_CENTER = 9,
+    LV_ALIGN_BOTTOM_MID = 5,
+    LV_ALIGN_OUT_BOTTOM_MID = 14,
+};
+enum { LV_LABEL_LONG_CLIP = 4 };
+
+lv_coord_t lv_pct(lv_coord_t x);
+lv_color_t lv_color_hex(uint32_t c);
+
+lv_obj_t *lv_scr_act(void);
+lv_obj_t *lv_obj_create(lv_obj_t *parent);
+lv_obj_t *lv_label_create(lv_obj_t *parent);
+lv_obj_t *lv_btn_create(lv_obj_t *parent);
+lv_obj_t *lv_switch_create(lv_obj_t *parent);
+lv_obj_t *lv_dropdown_create(lv_obj_t *parent);
+lv_obj_t *lv_tabview_create(lv_obj_t *parent, lv_dir_t tab_pos, lv_coord_t tab_size);
+lv_obj_t *lv_tabview_add_tab(lv_obj_t *tabview, const char *name);
+void lv_tabview_set_act(lv_obj_t *tabview, uint32_t id, lv_anim_enable_t anim);
+
+void lv_obj_set_size(lv_obj_t *obj, lv_coord_t w, lv_coord_t h);
+void lv_obj_set_width(lv_obj_t *obj, lv_coord_t w);
+void lv_obj_set_pos(lv_obj_t *obj, lv_coord_t x, lv_coord_t y);
+void lv_obj_align(lv_obj_t *obj, int align, lv_coord_t x, lv_coord_t y);
+void lv_obj_align_to(lv_obj_t *obj, const lv_obj_t *base, int align, lv_coord_t x, lv_coord_t y);
+void lv_obj_center(lv_obj_t *obj);
+void lv_obj_add_flag(lv_obj_t *obj, uint32_t flag);
+void lv_obj_clear_flag(lv_obj_t *obj, uint32_t flag);
+void lv_obj_add_state(lv_obj_t *obj, uint32_t state);
+bool lv_obj_has_state(const lv_obj_t *obj, uint32_t state);
+void lv_obj_add_event_cb(lv_obj_t *obj, lv_event_cb_t cb, lv_event_code_t filter, void *user_data);
+lv_obj_t *lv_obj_get_child(const lv_obj_t *obj, int32_t id);
+const lv_obj_class_t *lv_obj_get_class(const lv_obj_t *obj);
+void lv_obj_set_style_bg_color(lv_obj_t *obj, lv_color_t value, uint32_t selector);
+void lv_obj_set_style_text_color(lv_obj_t *obj, lv_color_t value, uint32_t selector);
+void lv_obj_set_style_border_color(lv_obj_t *obj, lv_color_t value, uint32_t selector);
+void lv_obj_set_style_border_width(lv_obj_t *obj, lv_coord_t value, uint32_t selector);
+void lv_obj_set_style_pad_all(lv_obj_t *obj, lv_coord_t value, uint32_t selector);
+
+void lv_label_set_text(lv_obj_t *obj, const char *text);
+void lv_label_set_long_mode(lv_obj_t *obj, int mode);
+void lv_dropdown_set_options(lv_obj_t *obj, const char *options);
+uint16_t lv_dropdown_get_selected(const lv_obj_t *obj);
+
+lv_obj_t *lv_event_get_target(lv_event_t *e);
+void *lv_event_get_user_data(lv_event_t *e);
+lv_indev_t *lv_indev_get_act(void);
+void lv_indev_get_vect(const lv_indev_t *indev, lv_point_t *point);
+
+uint32_t lv_timer_handler(void);
+
+#endif // HMI_HOST_LVGL_H
@@ -0,0 +1,10 @@
+// nvs_flash.h - Host shim
+
+#ifndef HMI_HOST_NVS_FLASH_H
+#define HMI_HOST_NVS_FLASH_H
+
+#include "esp_err.h"
+
+esp_err_t nvs_flash_init(void);
+
+#endif // HMI_HOST_NVS_FLASH_H
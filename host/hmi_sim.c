@@ -0,0 +1,512 @@
+// hmi_sim.c - Host implementations of the HMI shims (see hmi_sim.h)
+
+#include "hmi_sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp/esp-bsp.h"
+#include "esp_heap_caps.h"
+#include "esp_netif.h"
+#include "esp_sntp.h"
+#include "esp_spiffs.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "mqtt_client.h"
+#include "nvs_flash.h"
+
+// ===== Clock =====
+static uint64_t now_us = 0;
+
+void hmi_sim_advance_us(uint64_t us) {
+    now_us += us;
+}
+
+int64_t esp_timer_get_time(void) {
+    return (int64_t)now_us;
+}
+
+// ===== FreeRTOS =====
+struct hmi_sim_task {
+    const char *name;
+};
+
+struct hmi_sim_queue {
+    unsigned length;
+    unsigned item_size;
+    unsigned head; // Items ever sent
+    unsigned tail; // Items ever received
+    unsigned char *items;
+};
+
+struct hmi_sim_mutex {
+    int unused;
+};
+
+BaseType_t xTaskCreate(void (*task)(void *), const char *name, uint32_t stack, void *arg, unsigned priority,
+                       TaskHandle_t *handle) {
+    (void)task; (void)stack; (void)arg; (void)priority;
+    struct hmi_sim_task *created = calloc(1, sizeof(*created));
+    created->name = name;
+    if (handle) *handle = created;
+    return pdTRUE;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    hmi_sim_advance_us((uint64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+unsigned uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    (void)task;
+    return 0;
+}
+
+TaskHandle_t xTaskGetHandle(const char *name) {
+    (void)name;
+    return NULL;
+}
+
+QueueHandle_t xQueueCreate(unsigned length, unsigned item_size) {
+    QueueHandle_t queue = calloc(1, sizeof(*queue));
+    queue->length = length;
+    queue->item_size = item_size;
+    queue->items = calloc(length, item_size);
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait) {
+    (void)wait; // Nothing else runs, so waiting would never free a slot
+    if (queue->head - queue->tail >= queue->length) return pdFALSE;
+    memcpy(queue->items + (queue->head % queue->length) * queue->item_size, item, queue->item_size);
+    queue->head++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait) {
+    (void)wait;
+    if (queue->head == queue->tail) return pdFALSE;
+    memcpy(item, queue->items + (queue->tail % queue->length) * queue->item_size, queue->item_size);
+    queue->tail++;
+    return pdTRUE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return calloc(1, sizeof(struct hmi_sim_mutex));
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t wait) {
+    (void)mutex; (void)wait;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+    (void)mutex;
+    return pdTRUE;
+}
+
+size_t hmi_sim_strlcpy(char *dst, const char *src, size_t size) {
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+
+// ===== Heap =====
+bool hmi_sim_has_psram = true;
+static hmi_sim_heap_t heap = {0, 0};
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    if ((caps & MALLOC_CAP_SPIRAM) && !hmi_sim_has_psram) return NULL;
+    void *block = calloc(n, size);
+    if (!block) return NULL;
+    if (caps & MALLOC_CAP_SPIRAM) heap.psram += n * size;
+    else heap.internal += n * size;
+    return block;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    (void)caps;
+    return 0;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    (void)caps;
+    return 0;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    (void)caps;
+    return 0;
+}
+
+hmi_sim_heap_t hmi_sim_heap(void) {
+    return heap;
+}
+
+// ===== ESP-IDF Stubs =====
+esp_event_base_t WIFI_EVENT = "WIFI_EVENT";
+esp_event_base_t IP_EVENT = "IP_EVENT";
+
+const char *esp_err_to_name(esp_err_t err) {
+    return err == ESP_OK ? "ESP_OK" : "ESP_FAIL";
+}
+
+esp_err_t esp_event_loop_create_default(void) { return ESP_OK; }
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler, void *arg) {
+    (void)base; (void)id; (void)handler; (void)arg;
+    return ESP_OK;
+}
+esp_err_t esp_netif_init(void) { return ESP_OK; }
+esp_netif_t *esp_netif_create_default_wifi_sta(void) { return NULL; }
+esp_err_t esp_wifi_init(const wifi_init_config_t *config) { (void)config; return ESP_OK; }
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) { (void)mode; return ESP_OK; }
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *config) {
+    (void)interface; (void)config;
+    return ESP_OK;
+}
+esp_err_t esp_wifi_start(void) { return ESP_OK; }
+esp_err_t esp_wifi_connect(void) { return ESP_OK; }
+esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t *conf) { (void)conf; return ESP_FAIL; }
+esp_err_t nvs_flash_init(void) { return ESP_OK; }
+void esp_sntp_setoperatingmode(int mode) { (void)mode; }
+void esp_sntp_setservername(int index, const char *server) { (void)index; (void)server; }
+void esp_sntp_init(void) {}
+void bsp_display_start(void) {}
+void bsp_display_backlight_on(void) {}
+bool bsp_display_lock(uint32_t timeout_ms) { (void)timeout_ms; return true; }
+void bsp_display_unlock(void) {}
+
+// ===== MQTT =====
+#define SIM_MQTT_TOPICS 16
+
+struct hmi_sim_mqtt_client {
+    esp_event_handler_t handler;
+    void *handler_arg;
+};
+
+static struct hmi_sim_mqtt_client mqtt_client;
+static struct {
+    char topic[64];
+    uint32_t count;
+    int qos;        // Of the last message
+    char last[256]; // Last payload, cut to fit
+} enqueued[SIM_MQTT_TOPICS];
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *config) {
+    (void)config;
+    return &mqtt_client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, int32_t event, esp_event_handler_t handler,
+                                         void *arg) {
+    (void)event;
+    client->handler = handler;
+    client->handler_arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client) {
+    (void)client;
+    return ESP_OK;
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char *topic, int qos) {
+    (void)client; (void)topic; (void)qos;
+    return 1;
+}
+
+int esp_mqtt_client_enqueue(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos,
+                            int retain, bool store) {
+    (void)client; (void)retain; (void)store;
+    if (len == 0) len = (int)strlen(data);
+    for (int i = 0; i < SIM_MQTT_TOPICS; i++) {
+        if (enqueued[i].topic[0] == '\0') strlcpy(enqueued[i].topic, topic, sizeof(enqueued[i].topic));
+        if (strcmp(enqueued[i].topic, topic) == 0) {
+            enqueued[i].count++;
+            enqueued[i].qos = qos;
+            size_t copy = (size_t)len < sizeof(enqueued[i].last) ? (size_t)len : sizeof(enqueued[i].last) - 1;
+            memcpy(enqueued[i].last, data, copy);
+            enqueued[i].last[copy] = '\0';
+            break;
+        }
+    }
+    return 1;
+}
+
+uint32_t hmi_sim_mqtt_enqueued(const char *topic) {
+    for (int i = 0; i < SIM_MQTT_TOPICS; i++) {
+        if (strcmp(enqueued[i].topic, topic) == 0) return enqueued[i].count;
+    }
+    return 0;
+}
+
+const char *hmi_sim_mqtt_last(const char *topic, int *qos) {
+    for (int i = 0; i < SIM_MQTT_TOPICS; i++) {
+        if (strcmp(enqueued[i].topic, topic) == 0) {
+            if (qos) *qos = enqueued[i].qos;
+            return enqueued[i].last;
+        }
+    }
+    return NULL;
+}
+
+void hmi_sim_mqtt_deliver(const char *topic, const void *data, int len, int chunk) {
+    if (!mqtt_client.handler) return;
+    if (chunk <= 0 || chunk > len) chunk = len;
+    int offset = 0;
+    do {
+        // Each event gets an exact-size copy so a sanitizer sees any overread
+        int n = len - offset < chunk ? len - offset : chunk;
+        char *part = malloc(n ? n : 1);
+        memcpy(part, (const char *)data + offset, n);
+        esp_mqtt_event_t event = {0};
+        event.event_id = MQTT_EVENT_DATA;
+        event.client = &mqtt_client;
+        event.data = part;
+        event.data_len = n;
+        event.total_data_len = len;
+        event.current_data_offset = offset;
+        event.topic = offset == 0 ? (char *)topic : NULL;
+        event.topic_len = offset == 0 ? (int)strlen(topic) : 0;
+        mqtt_client.handler(mqtt_client.handler_arg, "MQTT", MQTT_EVENT_DATA, &event);
+        free(part);
+        offset += n;
+    } while (offset < len);
+}
+
+// ===== Fake LVGL =====
+#define SIM_MAX_EVENT_CBS 4
+
+struct _lv_obj_t {
+    const lv_obj_class_t *cls;
+    lv_obj_t *parent;
+    lv_obj_t **children;
+    uint32_t child_count;
+    uint32_t flags;
+    uint32_t state;
+    char *text;
+    bool invalid;
+    struct {
+        lv_event_cb_t cb;
+        lv_event_code_t filter;
+        void *user_data;
+    } events[SIM_MAX_EVENT_CBS];
+};
+
+struct _lv_event_t {
+    lv_obj_t *target;
+    void *user_data;
+};
+
+struct _lv_indev_t {
+    lv_point_t vect;
+};
+
+const lv_obj_class_t lv_obj_class = {"obj"};
+const lv_obj_class_t lv_label_class = {"label"};
+const lv_obj_class_t lv_btn_class = {"btn"};
+const lv_obj_class_t lv_switch_class = {"switch"};
+const lv_obj_class_t lv_dropdown_class = {"dropdown"};
+const lv_obj_class_t lv_tabview_class = {"tabview"};
+
+static hmi_sim_lvgl_t lvgl = {0, 0, 0, 0, 0};
+static uint64_t invalid_now = 0;
+static lv_obj_t *screen = NULL;
+static struct _lv_indev_t indev;
+
+static void invalidate(lv_obj_t *obj) {
+    if (!obj->invalid) {
+        obj->invalid = true;
+        invalid_now++;
+    }
+}
+
+static lv_obj_t *create(lv_obj_t *parent, const lv_obj_class_t *cls) {
+    lv_obj_t *obj = calloc(1, sizeof(*obj));
+    obj->cls = cls;
+    obj->parent = parent;
+    if (parent) {
+        parent->children = realloc(parent->children, (parent->child_count + 1) * sizeof(lv_obj_t *));
+        parent->children[parent->child_count++] = obj;
+    }
+    lvgl.objects++;
+    invalidate(obj);
+    return obj;
+}
+
+lv_obj_t *lv_scr_act(void) {
+    if (!screen) screen = create(NULL, &lv_obj_class);
+    return screen;
+}
+
+lv_obj_t *lv_obj_create(lv_obj_t *parent) { return create(parent, &lv_obj_class); }
+lv_obj_t *lv_label_create(lv_obj_t *parent) { return create(parent, &lv_label_class); }
+lv_obj_t *lv_btn_create(lv_obj_t *parent) { return create(parent, &lv_btn_class); }
+lv_obj_t *lv_switch_create(lv_obj_t *parent) { return create(parent, &lv_switch_class); }
+lv_obj_t *lv_dropdown_create(lv_obj_t *parent) { return create(parent, &lv_dropdown_class); }
+
+lv_obj_t *lv_tabview_create(lv_obj_t *parent, lv_dir_t tab_pos, lv_coord_t tab_size) {
+    (void)tab_pos; (void)tab_size;
+    return create(parent, &lv_tabview_class);
+}
+
+lv_obj_t *lv_tabview_add_tab(lv_obj_t *tabview, const char *name) {
+    (void)name;
+    return create(tabview, &lv_obj_class);
+}
+
+void lv_tabview_set_act(lv_obj_t *tabview, uint32_t id, lv_anim_enable_t anim) {
+    (void)id; (void)anim;
+    invalidate(tabview);
+}
+
+lv_coord_t lv_pct(lv_coord_t x) { return x; }
+
+lv_color_t lv_color_hex(uint32_t c) {
+    lv_color_t color = {c};
+    return color;
+}
+
+void lv_obj_set_size(lv_obj_t *obj, lv_coord_t w, lv_coord_t h) { (void)w; (void)h; invalidate(obj); }
+void lv_obj_set_width(lv_obj_t *obj, lv_coord_t w) { (void)w; invalidate(obj); }
+void lv_obj_set_pos(lv_obj_t *obj, lv_coord_t x, lv_coord_t y) { (void)x; (void)y; invalidate(obj); }
+void lv_obj_align(lv_obj_t *obj, int align, lv_coord_t x, lv_coord_t y) {
+    (void)align; (void)x; (void)y;
+    invalidate(obj);
+}
+void lv_obj_align_to(lv_obj_t *obj, const lv_obj_t *base, int align, lv_coord_t x, lv_coord_t y) {
+    (void)base; (void)align; (void)x; (void)y;
+    invalidate(obj);
+}
+void lv_obj_center(lv_obj_t *obj) { invalidate(obj); }
+
+void lv_obj_add_flag(lv_obj_t *obj, uint32_t flag) {
+    if ((obj->flags & flag) != flag) invalidate(obj);
+    obj->flags |= flag;
+}
+
+void lv_obj_clear_flag(lv_obj_t *obj, uint32_t flag) {
+    if (obj->flags & flag) invalidate(obj);
+    obj->flags &= ~flag;
+}
+
+void lv_obj_add_state(lv_obj_t *obj, uint32_t state) {
+    obj->state |= state;
+    invalidate(obj);
+}
+
+bool lv_obj_has_state(const lv_obj_t *obj, uint32_t state) {
+    return (obj->state & state) != 0;
+}
+
+void lv_obj_add_event_cb(lv_obj_t *obj, lv_event_cb_t cb, lv_event_code_t filter, void *user_data) {
+    for (int i = 0; i < SIM_MAX_EVENT_CBS; i++) {
+        if (!obj->events[i].cb) {
+            obj->events[i].cb = cb;
+            obj->events[i].filter = filter;
+            obj->events[i].user_data = user_data;
+            return;
+        }
+    }
+}
+
+lv_obj_t *lv_obj_get_child(const lv_obj_t *obj, int32_t id) {
+    return id >= 0 && (uint32_t)id < obj->child_count ? obj->children[id] : NULL;
+}
+
+const lv_obj_class_t *lv_obj_get_class(const lv_obj_t *obj) {
+    return obj->cls;
+}
+
+void lv_obj_set_style_bg_color(lv_obj_t *obj, lv_color_t value, uint32_t selector) {
+    (void)value; (void)selector;
+    invalidate(obj);
+}
+
+void lv_obj_set_style_text_color(lv_obj_t *obj, lv_color_t value, uint32_t selector) {
+    (void)value; (void)selector;
+    invalidate(obj);
+}
+
+void lv_obj_set_style_border_color(lv_obj_t *obj, lv_color_t value, uint32_t selector) {
+    (void)value; (void)selector;
+    invalidate(obj);
+}
+
+void lv_obj_set_style_border_width(lv_obj_t *obj, lv_coord_t value, uint32_t selector) {
+    (void)value; (void)selector;
+    invalidate(obj);
+}
+
+void lv_obj_set_style_pad_all(lv_obj_t *obj, lv_coord_t value, uint32_t selector) {
+    (void)value; (void)selector;
+    invalidate(obj);
+}
+
+// Like LVGL, the label keeps its own heap copy of the text
+void lv_label_set_text(lv_obj_t *obj, const char *text) {
+    size_t len = strlen(text) + 1;
+    if (obj->text) lvgl.text_bytes -= strlen(obj->text) + 1;
+    obj->text = realloc(obj->text, len);
+    memcpy(obj->text, text, len);
+    lvgl.text_bytes += len;
+    lvgl.label_sets++;
+    invalidate(obj);
+}
+
+void lv_label_set_long_mode(lv_obj_t *obj, int mode) { (void)mode; invalidate(obj); }
+void lv_dropdown_set_options(lv_obj_t *obj, const char *options) { lv_label_set_text(obj, options); }
+uint16_t lv_dropdown_get_selected(const lv_obj_t *obj) { (void)obj; return 0; }
+
+lv_obj_t *lv_event_get_target(lv_event_t *e) { return e->target; }
+void *lv_event_get_user_data(lv_event_t *e) { return e->user_data; }
+lv_indev_t *lv_indev_get_act(void) { return &indev; }
+void lv_indev_get_vect(const lv_indev_t *from, lv_point_t *point) { *point = from->vect; }
+
+// "Draws" every object invalidated since the last call
+uint32_t lv_timer_handler(void) {
+    lvgl.invalidations += invalid_now;
+    invalid_now = 0;
+    lvgl.timer_runs++;
+    // Walk from the screen clearing the marks; unparented objects are left alone
+    lv_obj_t *stack[256];
+    int depth = 0;
+    if (screen) stack[depth++] = screen;
+    while (depth > 0) {
+        lv_obj_t *obj = stack[--depth];
+        obj->invalid = false;
+        for (uint32_t i = 0; i < obj->child_count && depth < 256; i++) stack[depth++] = obj->children[i];
+    }
+    return 5; // ms until the next call, as LVGL reports it
+}
+
+hmi_sim_lvgl_t hmi_sim_lvgl(void) {
+    return lvgl;
+}
+
+const char *hmi_sim_label_text(const lv_obj_t *obj) {
+    return obj->text ? obj->text : "";
+}
+
+bool hmi_sim_hidden(const lv_obj_t *obj) {
+    return (obj->flags & LV_OBJ_FLAG_HIDDEN) != 0;
+}
+
+void hmi_sim_drag(lv_obj_t *obj, lv_coord_t dy) {
+    indev.vect.x = 0;
+    indev.vect.y = dy;
+    for (int i = 0; i < SIM_MAX_EVENT_CBS; i++) {
+        if (obj->events[i].cb && obj->events[i].filter == LV_EVENT_PRESSING) {
+            lv_event_t event = {obj, obj->events[i].user_data};
+            obj->events[i].cb(&event);
+        }
+    }
+}
@@ -0,0 +1,48 @@
+// hmi_sim.h - Virtual clock, fake LVGL counters, heap and MQTT for HMIESP32.C on Linux
+//
+// The HMI is built as C against the shims in hmi_shims/: ESP-IDF, FreeRTOS and
+// the MQTT client are stubs, LVGL is a fake that keeps objects but draws nothing
+// (see hmi_shims/lvgl.h). Tasks are never started; a test calls the firmware's
+// functions (ui_frame(), mqtt_event_handler(), ...) itself and moves the clock.
+
+#ifndef HMI_SIM_H
+#define HMI_SIM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lvgl.h"
+
+// ===== Clock =====
+void hmi_sim_advance_us(uint64_t us); // esp_timer_get_time() and vTaskDelay() use this clock
+
+// ===== Fake LVGL =====
+typedef struct {
+    uint64_t objects;       // Objects alive
+    uint64_t label_sets;    // lv_label_set_text() calls
+    uint64_t text_bytes;    // Label text held by all objects (LVGL keeps its own copy)
+    uint64_t invalidations; // Objects marked for redraw and drawn by lv_timer_handler()
+    uint64_t timer_runs;    // lv_timer_handler() calls
+} hmi_sim_lvgl_t;
+hmi_sim_lvgl_t hmi_sim_lvgl(void);
+const char *hmi_sim_label_text(const lv_obj_t *obj);
+bool hmi_sim_hidden(const lv_obj_t *obj);
+// Deliver a PRESSING event to obj, as if the finger moved dy pixels since the last one
+void hmi_sim_drag(lv_obj_t *obj, lv_coord_t dy);
+
+// ===== Heap =====
+typedef struct {
+    size_t psram;    // Bytes from heap_caps_calloc() with MALLOC_CAP_SPIRAM
+    size_t internal; // Other heap_caps_calloc() bytes
+} hmi_sim_heap_t;
+hmi_sim_heap_t hmi_sim_heap(void);
+extern bool hmi_sim_has_psram; // false: MALLOC_CAP_SPIRAM allocations fail
+
+// ===== MQTT =====
+// Deliver a message to the handler registered by mqtt_start(), in chunks of at
+// most chunk bytes (0 = whole) like the client's receive buffer does
+void hmi_sim_mqtt_deliver(const char *topic, const void *data, int len, int chunk);
+uint32_t hmi_sim_mqtt_enqueued(const char *topic); // Messages the HMI enqueued on topic
+const char *hmi_sim_mqtt_last(const char *topic, int *qos); // Last payload and QoS enqueued on topic, NULL if none
+
+#endif // HMI_SIM_H
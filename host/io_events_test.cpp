@@ -0,0 +1,78 @@
+// io_events_test.cpp - I/O task -> loop events while the loop is stalled
+//
+// A blocking reconnect keeps the loop from draining ioEvents while the I/O task
+// keeps acting on ESP-NOW and queued commands. Once the ring is full, the newest
+// direction, brake and output events must still reach the loop, so that
+// currentDirection, the logs and the command echo agree with the pins.
+
+#include "MotorESP32S3.cpp"
+#include "sim.h"
+
+#include <string.h>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-60s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+// The I/O task runs, loop() does not
+static void stall(uint8_t type, uint8_t arg, IoQueue<IoCommand>& queue = espNowCommands) {
+    {
+        SimFirmwareScope scope;
+        queueIoCommand(queue, type, arg, halMicros());
+    }
+    simAdvanceUs(IO_TASK_PERIOD_MS * 1000);
+}
+
+// Last of the two log lines found in serialLogs, NULL if neither is there
+static const char* lastOf(const char* a, const char* b) {
+    const char* lastA = NULL;
+    const char* lastB = NULL;
+    for (const char* p = serialLogs; (p = strstr(p, a)); p++) lastA = p;
+    for (const char* p = serialLogs; (p = strstr(p, b)); p++) lastB = p;
+    if (!lastA || !lastB) return lastA ? a : lastB ? b : NULL;
+    return lastA > lastB ? a : b;
+}
+
+int main() {
+    simBoot();
+    simSetPin(greenLEDs[0], HIGH); // G00, no alarm: nothing is locked
+    simSetPin(greenLEDs[1], HIGH);
+    simSetPin(greenLEDs[2], HIGH);
+    simSetPin(greenLEDs[3], HIGH);
+    simRun(2000000);
+    stall(IO_CMD_OUTPUT, USF_CMD_UP, ioCommands);
+    simRun(100000);
+
+    printf("loop stalled while the I/O task posts %d events\n", IO_QUEUE_SIZE + 12);
+    uint32_t refusedBefore = ioEvents.full.load();
+    for (int i = 0; i < IO_QUEUE_SIZE / 2 + 5; i++) {
+        stall(IO_CMD_MOVE, USF_DIR_UP);
+        stall(IO_CMD_MOVE, USF_DIR_STOP);
+    }
+    stall(IO_CMD_BRAKE, 0);
+    stall(IO_CMD_MOVE, USF_DIR_UP);
+    stall(IO_CMD_BRAKE, 1);
+    stall(IO_CMD_OUTPUT, USF_CMD_DOWN | IO_OUTPUT_ECHO, ioCommands);
+    simAdvanceUs(50000); // Past the reversal dead time
+    check(ioEvents.full.load() > refusedBefore, "event ring filled up");
+    check(simPinLevel(UP_PIN) == HIGH && simPinLevel(BRAKE_PIN) == HIGH && simPinLevel(DOWN_OUTPUT_PIN) == HIGH,
+          "every command still carried out");
+
+    printf("loop running again\n");
+    simRun(500000);
+    {
+        SimFirmwareScope scope;
+        flushLogBuffer();
+    }
+    check(ioUnreportedMask == 0, "refused state events all posted");
+    check(currentDirection == "up", "currentDirection matches UP_PIN");
+    const char* brake = lastOf("Brake applied", "Brake released");
+    check(brake && strcmp(brake, "Brake applied") == 0, "last brake log matches BRAKE_PIN");
+    check(simBroker.count(commandLogTopic, "Command executed: COMMAND:DOWN") == 1, "binary DOWN echoed once carried out");
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
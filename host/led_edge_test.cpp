@@ -0,0 +1,89 @@
+// led_edge_test.cpp - Edge traces replayed through ledEdgeISR()/LEDEdgeRing and updateLEDState()
+//
+// Each case drives one LED input with a list of (ms, level) edges on the virtual
+// clock, drains the ring every 5 ms like the I/O task and checks the classified
+// mode (and flash period) at the given time.
+
+#include "MotorESP32S3.cpp"
+#include "sim.h"
+
+#include <vector>
+
+struct Edge {
+    unsigned long ms;
+    int level;
+};
+
+struct EdgeCase {
+    const char* name;
+    std::vector<Edge> edges;
+    unsigned long checkMs;       // When the classification is checked
+    LEDMode mode;
+    unsigned long flashPeriod;   // Expected period (ms) if FLASHING, 0 = don't check
+    bool drain;                  // false: nothing drains the ring until checkMs
+};
+
+static std::vector<Edge> flash(unsigned long fromMs, unsigned long halfMs, int edges, int firstLevel = 1) {
+    std::vector<Edge> out;
+    for (int i = 0; i < edges; i++) out.push_back({fromMs + i * halfMs, (firstLevel + i) & 1});
+    return out;
+}
+
+static std::vector<Edge> join(std::vector<Edge> a, const std::vector<Edge>& b) {
+    a.insert(a.end(), b.begin(), b.end());
+    return a;
+}
+
+static int runCase(const EdgeCase& test, uint8_t pin) {
+    LEDState led;
+    LEDEdgeRing ring;
+    uint64_t originUs = simNowUs();
+    simSetPin(pin, 0);
+    initLEDCapture(led, ring, pin);
+    for (const Edge& edge : test.edges) simSchedulePin(pin, edge.level, originUs + edge.ms * 1000);
+
+    for (unsigned long ms = 5; ms <= test.checkMs; ms += 5) {
+        simAdvanceUs(originUs + ms * 1000 - simNowUs());
+        if (test.drain || ms == test.checkMs) {
+            SimFirmwareScope scope;
+            updateLEDState(led, ring);
+        }
+    }
+
+    bool ok = led.mode == test.mode &&
+              (test.mode != LED_MODE_FLASHING || test.flashPeriod == 0 || led.flashPeriod == test.flashPeriod);
+    printf("  %-44s %-8s", test.name, ledStateNames[led.mode]);
+    if (led.mode == LED_MODE_FLASHING) printf(" %4lu ms", led.flashPeriod);
+    if (!ok) printf("  FAIL: expected %s", ledStateNames[test.mode]);
+    printf("\n");
+
+    halAttachEdgeInterrupt(pin, NULL, NULL);
+    simSetPin(pin, 0);
+    return ok ? 0 : 1;
+}
+
+int main() {
+    const EdgeCase cases[] = {
+        {"steady on", {{100, 1}}, 3000, LED_MODE_ON, 0, true},
+        {"two edges are not a flash", flash(100, 250, 2), 500, LED_MODE_OFF, 0, true},
+        {"flash 2 Hz after three edges", flash(100, 250, 3), 700, LED_MODE_FLASHING, 500, true},
+        {"flash held for 10 s", flash(100, 250, 40), 10000, LED_MODE_FLASHING, 500, true},
+        {"slow flash 1.4 s half period", flash(100, 1400, 6), 7200, LED_MODE_FLASHING, 2800, true},
+        {"1.6 s half period is not a flash", flash(100, 1600, 6), 8100, LED_MODE_OFF, 0, true},
+        {"flash stopped ON -> ON after 1.5 s", flash(100, 250, 9), 2100 + 1600, LED_MODE_ON, 0, true},
+        {"flash stopped OFF -> OFF after 1.5 s", flash(100, 250, 10), 2350 + 1600, LED_MODE_OFF, 0, true},
+        {"flash not yet stopped at 1.4 s", flash(100, 250, 10), 2350 + 1400, LED_MODE_FLASHING, 500, true},
+        {"contact bounce on switch-on", {{100, 1}, {105, 0}, {110, 1}, {112, 0}, {115, 1}}, 3000, LED_MODE_ON, 0,
+         true},
+        {"bounce on every flash edge",
+         join(join(flash(100, 250, 6), flash(103, 250, 6, 0)), flash(106, 250, 6)), 1400, LED_MODE_FLASHING, 500,
+         true},
+        {"flash through a 3 s drain stall", flash(100, 250, 12), 3000, LED_MODE_FLASHING, 500, false},
+        {"ring overflow re-reads the pin", flash(100, 30, LED_EDGE_RING_SIZE + 5), 4000, LED_MODE_ON, 0, false},
+    };
+
+    int failures = 0;
+    for (const EdgeCase& test : cases) failures += runCase(test, redLEDs[0]);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,141 @@
+// metrics_test.cpp - usf_metrics.h histograms and the command latency metric
+//
+// - Only UP/DOWN/STOP reach the I/O task: the device's own "Command executed"
+//   echoes and unknown binary commands are dropped in callback()
+// - The command latency is observed only when a command changed a pin
+// - 64-bit sum and buckets, and seqlock reads that never see a half-done
+//   observation while another thread writes
+// - Host ns per usf_hist_observe(), the cost every hot path pays
+
+#include "MotorESP32S3.cpp"
+#include "sim.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-60s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static uint32_t commandsQueued() {
+    return ioCommands.head.load();
+}
+
+static uint64_t commandsObserved() {
+    usf_hist_t hist;
+    usf_hist_read(&commandHist, &hist);
+    return usf_hist_count(&hist);
+}
+
+static void injectCommand(const char* message) {
+    simBroker.inject(commandLogTopic,
+                     std::string("{\"type\":\"command\",\"message\":\"") + message + "\",\"timestamp\":\"test\"}");
+    simRun(200 * 1000);
+}
+
+static void injectFrame(uint8_t command) {
+    usf_frame_t frame;
+    usf_frame_init(&frame, USF_MSG_COMMAND, 1, 0);
+    frame.command = command;
+    simBroker.inject(binCommandTopic, std::string((const char*)&frame, sizeof(frame)));
+    simRun(200 * 1000);
+}
+
+static void commandPath() {
+    printf("command path\n");
+    uint32_t queued = commandsQueued();
+    uint64_t observed = commandsObserved();
+    injectFrame(USF_CMD_UP);
+    check(simPinLevel(UP_OUTPUT_PIN) == HIGH, "binary UP sets the output");
+    check(simBroker.count(commandLogTopic, "Command executed") > 0, "and is echoed on the command log");
+    check(commandsQueued() - queued == 1, "the echo coming back is not queued as a command");
+    check(commandsObserved() - observed == 1, "latency observed once");
+
+    queued = commandsQueued();
+    injectCommand("Command executed: UP");
+    check(commandsQueued() == queued, "a movement echo is not queued either");
+
+    queued = commandsQueued();
+    observed = commandsObserved();
+    injectCommand("COMMAND:UP");
+    check(commandsQueued() - queued == 1 && commandsObserved() == observed, "repeated UP changes no pin: not observed");
+
+    queued = commandsQueued();
+    injectCommand("hello");
+    injectFrame(USF_CMD_NONE);
+    injectFrame(9);
+    check(commandsQueued() == queued, "unknown text and binary commands are not queued");
+
+    observed = commandsObserved();
+    injectCommand("COMMAND:STOP");
+    check(simPinLevel(UP_OUTPUT_PIN) == LOW && commandsObserved() - observed == 1, "STOP clears it, observed once");
+}
+
+static void wideCounters() {
+    printf("64-bit counters\n");
+    usf_hist_t hist = {};
+    for (int i = 0; i < 3; i++) usf_hist_observe(&hist, 4000000000u);
+    check(hist.sum_us == 12000000000ull, "sum past 2^32 us does not wrap");
+    check(hist.buckets[USF_HIST_BOUNDS] == 3 && usf_hist_count(&hist) == 3, "overflow bucket counts them");
+}
+
+// One writer alternating 1 us and 100 us, so every consistent copy has
+// sum == buckets[0] + 100 * (the 100 us bucket)
+static void seqlock() {
+    printf("seqlock\n");
+    static usf_hist_t hist;
+    std::atomic<bool> done(false);
+    std::thread writer([&done]() {
+        for (int i = 0; i < 5000000; i++) usf_hist_observe(&hist, 1 + (i & 1) * 99);
+        done = true;
+    });
+    uint64_t reads = 0, torn = 0, retried = 0;
+    while (!done) {
+        usf_hist_t copy;
+        if (!usf_hist_read(&hist, &copy)) {
+            retried++;
+            continue;
+        }
+        reads++;
+        if (copy.sum_us != copy.buckets[0] + copy.buckets[usf_hist_bucket(100)] * 100) torn++;
+    }
+    writer.join();
+    printf("  %llu reads during 5M observations, %llu torn, %llu gave up\n", (unsigned long long)reads,
+           (unsigned long long)torn, (unsigned long long)retried);
+    check(reads > 0 && torn == 0, "no read saw a half-done observation");
+
+    hist.seq++; // Writer preempted mid-update
+    usf_hist_t copy;
+    uint32_t p50, p99;
+    usf_hist_t last = {};
+    check(!usf_hist_read(&hist, &copy) && usf_hist_interval(&hist, &last, &p50, &p99) == 0,
+          "reader gives up instead of spinning on a stalled writer");
+    hist.seq++;
+    check(usf_hist_interval(&hist, &last, &p50, &p99) == 5000000, "next interval catches up");
+}
+
+static void overhead() {
+    const int observations = 20000000;
+    static usf_hist_t hist;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < observations; i++) usf_hist_observe(&hist, (uint32_t)i & 0xFFFFF);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("overhead: %.2f ns per usf_hist_observe() (host CPU)\n", ns / observations);
+    check(usf_hist_count(&hist) == (uint64_t)observations, "every observation counted");
+}
+
+int main() {
+    simBoot();
+    simRun(2000 * 1000);
+    commandPath();
+    wideCounters();
+    seqlock();
+    overhead();
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,257 @@
+// motor_scenarios.cpp - Replays an LED/button/MQTT trace through the motor firmware
+//
+// Usage: motor_scenarios <file.trace>
+// Boots the firmware on the simulator, runs the trace and reports the measured
+// latencies, loop()/I/O cycle time percentiles and heap high-water marks. Exits
+// non-zero if an expectation fails or a latency is over its limit.
+//
+// Trace lines are "<ms> <command> <args>", times counted from the end of boot:
+//   pin <name> <0|1>                        drive an input (LED inputs fire the edge ISR)
+//   flash <name> <half period ms> <until ms> toggle an input until the given time
+//   mqtt <topic> <payload>                   message from another client (rest of the line)
+//   command <UP|DOWN|STOP>                   binary command frame from the HMI
+//   broker <up|down>  /  wifi <up|down>
+//   measure <label> pin <name> <0|1> [max ms]           time until an output reaches a level
+//   measure <label> publish <topic> <text> [max ms]     time until a publish containing text
+//   expect pin <name> <0|1>                 the pin is at that level now
+//   expect led <name> <off|on|flashing>     the edge classifier reports that mode now
+//   expect publish <topic> <text> <count>   that many publishes contained text so far
+//   end                                     stop here and report
+// Pin names: UP_BUTTON DOWN_BUTTON UP_PIN DOWN_PIN BRAKE_PIN UP_OUTPUT_PIN
+// DOWN_OUTPUT_PIN RED0-3 GREEN0-3. '#' starts a comment.
+
+#include "MotorESP32S3.cpp"
+#include "sim.h"
+
+#include <strings.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct PinWrite {
+    uint8_t pin;
+    int level;
+    uint64_t timeUs;
+};
+
+struct Measure {
+    std::string label;
+    bool publish;        // Else a pin level
+    int pin;
+    int level;
+    std::string topic;
+    std::string text;
+    uint64_t startUs;
+    long maxMs;          // -1 = no limit
+};
+
+static std::vector<PinWrite> pinWrites;
+static std::vector<Measure> measures;
+static int failures = 0;
+
+static int pinByName(const std::string& name) {
+    struct { const char* name; int pin; } named[] = {
+        {"UP_BUTTON", UP_BUTTON}, {"DOWN_BUTTON", DOWN_BUTTON}, {"UP_PIN", UP_PIN}, {"DOWN_PIN", DOWN_PIN},
+        {"BRAKE_PIN", BRAKE_PIN}, {"UP_OUTPUT_PIN", UP_OUTPUT_PIN}, {"DOWN_OUTPUT_PIN", DOWN_OUTPUT_PIN},
+    };
+    for (const auto& entry : named) {
+        if (name == entry.name) return entry.pin;
+    }
+    if (name.size() == 4 && name.compare(0, 3, "RED") == 0 && name[3] >= '0' && name[3] < '0' + numLEDs) {
+        return redLEDs[name[3] - '0'];
+    }
+    if (name.size() == 6 && name.compare(0, 5, "GREEN") == 0 && name[5] >= '0' && name[5] < '0' + numLEDs) {
+        return greenLEDs[name[5] - '0'];
+    }
+    return -1;
+}
+
+static LEDState* ledByName(const std::string& name) {
+    int pin = pinByName(name);
+    for (int i = 0; i < numLEDs; i++) {
+        if (redLEDs[i] == pin) return &redLEDStates[i];
+        if (greenLEDs[i] == pin) return &greenLEDStates[i];
+    }
+    return NULL;
+}
+
+static void fail(int lineNo, const std::string& what) {
+    printf("  FAIL line %d: %s (at %.3f s)\n", lineNo, what.c_str(), simNowUs() / 1e6);
+    failures++;
+}
+
+// Microseconds from start until the measured condition, or -1 if it never happened
+static long long measureLatency(const Measure& measure) {
+    if (measure.publish) {
+        for (const SimMessage& message : simBroker.published) {
+            if (message.timeUs >= measure.startUs && message.topic == measure.topic &&
+                message.payload.find(measure.text) != std::string::npos) {
+                return (long long)(message.timeUs - measure.startUs);
+            }
+        }
+        return -1;
+    }
+    for (const PinWrite& write : pinWrites) {
+        if (write.timeUs >= measure.startUs && write.pin == measure.pin && write.level == measure.level) {
+            return (long long)(write.timeUs - measure.startUs);
+        }
+    }
+    return -1;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <file.trace>\n", argv[0]);
+        return 2;
+    }
+    std::ifstream trace(argv[1]);
+    if (!trace) {
+        fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 2;
+    }
+
+    simBoot();
+    SimHeapStats bootHeap = simHeap();
+    simHeapReset();
+    simLoopNs.clear();
+    simIoCycleNs.clear();
+    uint64_t originUs = simNowUs();
+    simOnPinWrite([](uint8_t pin, int level) {
+        pinWrites.push_back({pin, level, simNowUs()});
+    });
+    printf("trace %s\n", argv[1]);
+
+    std::string line;
+    int lineNo = 0;
+    bool ended = false;
+    while (!ended && std::getline(trace, line)) {
+        lineNo++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream in(line);
+        unsigned long atMs;
+        std::string command;
+        if (!(in >> atMs >> command)) continue;
+
+        uint64_t atUs = originUs + (uint64_t)atMs * 1000;
+        if (atUs > simNowUs()) simRun(atUs - simNowUs());
+
+        if (command == "pin") {
+            std::string name;
+            int level;
+            in >> name >> level;
+            if (pinByName(name) < 0) fail(lineNo, "unknown pin " + name);
+            else simSetPin(pinByName(name), level);
+        } else if (command == "flash") {
+            std::string name;
+            unsigned long halfMs, untilMs;
+            in >> name >> halfMs >> untilMs;
+            int pin = pinByName(name);
+            if (pin < 0 || halfMs == 0) {
+                fail(lineNo, "bad flash " + name);
+                continue;
+            }
+            int level = !simPinLevel(pin);
+            for (uint64_t t = atUs; t < originUs + (uint64_t)untilMs * 1000; t += halfMs * 1000, level = !level) {
+                simSchedulePin(pin, level, t);
+            }
+        } else if (command == "mqtt") {
+            std::string topic, payload;
+            in >> topic;
+            std::getline(in >> std::ws, payload);
+            simBroker.inject(topic, payload);
+        } else if (command == "command") {
+            std::string text;
+            in >> text;
+            usf_frame_t frame;
+            usf_frame_init(&frame, USF_MSG_COMMAND, lineNo, atMs);
+            frame.command = usf_command_from_text(("COMMAND:" + text).c_str());
+            simBroker.inject(USF_BIN_COMMAND_TOPIC, std::string((const char*)&frame, sizeof(frame)));
+        } else if (command == "broker" || command == "wifi") {
+            std::string state;
+            in >> state;
+            if (command == "broker") simBroker.setUp(state == "up");
+            else simWiFiUp = state == "up";
+        } else if (command == "measure") {
+            Measure measure;
+            std::string kind;
+            in >> measure.label >> kind;
+            measure.publish = kind == "publish";
+            measure.startUs = simNowUs();
+            measure.maxMs = -1;
+            measure.pin = -1;
+            measure.level = 0;
+            if (measure.publish) {
+                in >> measure.topic >> measure.text;
+            } else {
+                std::string name;
+                in >> name >> measure.level;
+                measure.pin = pinByName(name);
+                if (measure.pin < 0) fail(lineNo, "unknown pin " + name);
+            }
+            in >> measure.maxMs;
+            measures.push_back(measure);
+        } else if (command == "expect") {
+            std::string kind, name;
+            in >> kind >> name;
+            if (kind == "pin") {
+                int level;
+                in >> level;
+                int pin = pinByName(name);
+                if (pin < 0 || simPinLevel(pin) != level) fail(lineNo, "expected " + name + " " + std::to_string(level));
+            } else if (kind == "led") {
+                std::string mode;
+                in >> mode;
+                LEDState* led = ledByName(name);
+                if (!led || strcasecmp(mode.c_str(), ledStateNames[led->mode]) != 0) {
+                    fail(lineNo, "expected " + name + " " + mode + ", classified " +
+                                 (led ? ledStateNames[led->mode] : "?"));
+                }
+            } else if (kind == "publish") {
+                std::string text;
+                size_t count;
+                in >> text >> count;
+                size_t seen = simBroker.count(name, text.c_str());
+                if (seen != count) {
+                    fail(lineNo, "expected " + std::to_string(count) + " publishes of " + text + " on " + name +
+                                 ", saw " + std::to_string(seen));
+                }
+            } else {
+                fail(lineNo, "unknown expectation " + kind);
+            }
+        } else if (command == "end") {
+            ended = true;
+        } else {
+            fail(lineNo, "unknown command " + command);
+        }
+    }
+
+    printf("  simulated %.1f s, %zu publishes\n", (simNowUs() - originUs) / 1e6, simBroker.published.size());
+    for (const Measure& measure : measures) {
+        long long us = measureLatency(measure);
+        if (us < 0) {
+            printf("  latency %-28s never\n", measure.label.c_str());
+            failures++;
+            continue;
+        }
+        bool over = measure.maxMs >= 0 && us > measure.maxMs * 1000LL;
+        printf("  latency %-28s %9.3f ms", measure.label.c_str(), us / 1000.0);
+        if (measure.maxMs >= 0) printf("  (limit %ld ms)%s", measure.maxMs, over ? "  OVER" : "");
+        printf("\n");
+        if (over) failures++;
+    }
+
+    // Host CPU time: compare runs on the same machine, not with the ESP32
+    printf("  loop()    %8zu passes  p50 %6lu ns  p99 %6lu ns  max %7lu ns (host CPU)\n", simLoopNs.size(),
+           (unsigned long)simPercentile(simLoopNs, 50), (unsigned long)simPercentile(simLoopNs, 99),
+           (unsigned long)simPercentile(simLoopNs, 100));
+    printf("  I/O cycle %8zu cycles  p50 %6lu ns  p99 %6lu ns  max %7lu ns (host CPU)\n", simIoCycleNs.size(),
+           (unsigned long)simPercentile(simIoCycleNs, 50), (unsigned long)simPercentile(simIoCycleNs, 99),
+           (unsigned long)simPercentile(simIoCycleNs, 100));
+    SimHeapStats heap = simHeap();
+    printf("  heap      boot peak %zu B, in use %zu B, run peak %zu B, %llu allocations (%llu B) while running\n",
+           bootHeap.peak, heap.used, heap.peak, (unsigned long long)heap.allocs, (unsigned long long)heap.allocBytes);
+    printf("  %s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
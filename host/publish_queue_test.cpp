@@ -0,0 +1,130 @@
+// publish_queue_test.cpp - MQTT publish queue and SPIFFS spill against the simulated broker
+//
+// - Heap bytes allocated per publish (enqueue + send), which must be zero
+// - Everything queued while connected reaches the broker once, in order
+// - A forced 60 s broker outage under log chatter: every alert raised during it
+//   is delivered after the reconnect, once and in order, even though the RAM
+//   queue overflows into the spill file and log entries may be dropped
+
+#include "MotorESP32S3.cpp"
+#include "sim.h"
+
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-60s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+// Run loop() until the queue and spill file are empty (or the time runs out)
+static void drainAll(uint64_t maxUs) {
+    uint64_t end = simNowUs() + maxUs;
+    while (simNowUs() < end && (publishQueueCount > 0 || spillPending || spillEntryLoaded)) simRun(10 * 1000);
+}
+
+static void allocationsPerPublish() {
+    const int publishes = 1000;
+    simHeapReset();
+    {
+        SimFirmwareScope scope;
+        for (int i = 0; i < publishes; i++) {
+            char msg[48];
+            snprintf(msg, sizeof(msg), "heap probe %d", i);
+            publishGeneralLog(msg, "info");
+            drainPublishQueue();
+        }
+    }
+    SimHeapStats heap = simHeap();
+    printf("allocations: %d publishes (2 topics each), %llu allocations, %.1f bytes per publish\n", publishes,
+           (unsigned long long)heap.allocs, (double)heap.allocBytes / publishes);
+    check(heap.allocs == 0, "publish path allocates nothing");
+}
+
+static void orderWhileConnected() {
+    size_t before = simBroker.published.size();
+    {
+        SimFirmwareScope scope;
+        for (int i = 0; i < 50; i++) {
+            char msg[48];
+            snprintf(msg, sizeof(msg), "order %03d", i);
+            publishCommandLog(msg);
+        }
+    }
+    drainAll(5 * 1000 * 1000);
+    int next = 0;
+    bool inOrder = true;
+    for (size_t i = before; i < simBroker.published.size(); i++) {
+        const SimMessage& message = simBroker.published[i];
+        if (message.topic != commandLogTopic) continue;
+        char expected[24];
+        snprintf(expected, sizeof(expected), "order %03d", next);
+        if (message.payload.find(expected) == std::string::npos) inOrder = false;
+        next++;
+    }
+    printf("connected: 50 command logs queued, %d delivered\n", next);
+    check(next == 50 && inOrder, "all delivered once, in order");
+}
+
+static void outage() {
+    const int outageSeconds = 60;
+    const int chatterPerSecond = 10;
+    size_t before = simBroker.published.size();
+    unsigned long droppedBefore = publishDropped;
+    size_t spillPeak = 0;
+
+    simBroker.setUp(false);
+    int alerts = 0;
+    uint64_t outageEnd = simNowUs() + (uint64_t)outageSeconds * 1000 * 1000;
+    while (simNowUs() < outageEnd) {
+        {
+            SimFirmwareScope scope;
+            for (int i = 0; i < chatterPerSecond; i++) publishGeneralLog("chatter while the broker is away", "info");
+            char msg[48];
+            snprintf(msg, sizeof(msg), "R10 - outage alert %03d", alerts++);
+            publishAlert("red", msg);
+        }
+        simRun(1000 * 1000);
+        File spill = SPIFFS.open(PUBLISH_SPILL_FILE, FILE_READ);
+        if (spill && spill.size() > spillPeak) spillPeak = spill.size();
+    }
+    simBroker.setUp(true);
+    uint64_t upUs = simNowUs();
+    drainAll(120ull * 1000 * 1000);
+
+    int next = 0;
+    bool inOrder = true;
+    uint64_t lastDeliveredUs = upUs;
+    for (size_t i = before; i < simBroker.published.size(); i++) {
+        const SimMessage& message = simBroker.published[i];
+        if (message.topic != alertLogTopic || message.payload.find("outage alert") == std::string::npos) continue;
+        char expected[24];
+        snprintf(expected, sizeof(expected), "outage alert %03d", next);
+        if (message.payload.find(expected) == std::string::npos) inOrder = false;
+        lastDeliveredUs = message.timeUs;
+        next++;
+    }
+    printf("outage: %d s, %d alerts + %d log lines raised, spill file peak %zu B, %lu entries dropped, "
+           "%d alerts delivered %.1f s after the reconnect\n",
+           outageSeconds, alerts, outageSeconds * chatterPerSecond, spillPeak, publishDropped - droppedBefore, next,
+           (lastDeliveredUs - upUs) / 1e6);
+    check(spillPeak > 0, "RAM queue overflowed into the spill file");
+    check(next == alerts && inOrder, "no alert lost, duplicated or reordered");
+    check(publishQueueCount == 0 && !spillPending, "queue and spill file fully drained");
+}
+
+int main() {
+    simBoot();
+    simRun(2000 * 1000);
+    if (!mqttClient.connected()) {
+        printf("broker not connected after boot\nFAILED\n");
+        return 1;
+    }
+    allocationsPerPublish();
+    orderWhileConnected();
+    outage();
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
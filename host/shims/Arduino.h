@@ -0,0 +1,94 @@
+// Arduino.h - Host shim of the ESP32 Arduino core for the simulation build
+//
+// Only what MotorESP32S3.ino uses. Time comes from the simulator's virtual
+// clock (sim.h), so delay() advances it instead of sleeping.
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+#include "WString.h"
+#include "Esp.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+
+#define CHANGE 0x03
+
+#define IRAM_ATTR
+#define PROGMEM
+
+#define DEC 10
+#define HEX 16
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+long random(long howbig);
+long random(long howsmall, long howbig);
+
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+void pinMode(uint8_t pin, uint8_t mode);
+#define digitalPinToInterrupt(pin) (pin)
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode);
+
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char* server1);
+bool getLocalTime(struct tm* info, uint32_t ms = 5000);
+
+// ===== Print =====
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(const uint8_t* buffer, size_t size) = 0;
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write((const uint8_t*)text.c_str(), text.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(const T& value) { return print(value) + println(); }
+    template <typename T> size_t println(const T& value, int format) { return print(value, format) + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+// Serial output is dropped unless USF_SIM_SERIAL is set in the environment
+class HardwareSerial : public Print {
+  public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
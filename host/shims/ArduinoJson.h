@@ -0,0 +1,43 @@
+// ArduinoJson.h - Host shim: just enough of ArduinoJson 6 for the MQTT callback
+//
+// deserializeJson() accepts one flat object; string members can be read back
+// as const char*, any other member reads as NULL like it would for a string.
+
+#ifndef HOST_ARDUINOJSON_H
+#define HOST_ARDUINOJSON_H
+
+#include <stddef.h>
+#include <string.h>
+#include <map>
+#include <string>
+
+class DeserializationError {
+  public:
+    enum Code { Ok, InvalidInput, NoMemory };
+    DeserializationError(Code code = Ok) : code(code) {}
+    explicit operator bool() const { return code != Ok; }
+    const char* c_str() const { return code == Ok ? "Ok" : code == InvalidInput ? "InvalidInput" : "NoMemory"; }
+
+  private:
+    Code code;
+};
+
+class JsonDocument {
+  public:
+    struct Member {
+        const char* value;
+        operator const char*() const { return value; }
+    };
+    Member operator[](const char* key) const {
+        auto it = strings.find(key);
+        return {it == strings.end() ? NULL : it->second.c_str()};
+    }
+    std::map<std::string, std::string> strings;
+};
+
+template <size_t N>
+class StaticJsonDocument : public JsonDocument {};
+
+DeserializationError deserializeJson(JsonDocument& doc, const char* input);
+
+#endif // HOST_ARDUINOJSON_H
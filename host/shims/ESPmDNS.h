@@ -0,0 +1,13 @@
+// ESPmDNS.h - Host shim: no mDNS in the simulator
+
+#ifndef HOST_ESPMDNS_H
+#define HOST_ESPMDNS_H
+
+class MDNSResponder {
+  public:
+    bool begin(const char* hostName) { (void)hostName; return true; }
+};
+
+extern MDNSResponder MDNS;
+
+#endif // HOST_ESPMDNS_H
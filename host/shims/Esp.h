@@ -0,0 +1,21 @@
+// Esp.h - Host shim of the ESP class: heap figures come from the simulator's
+// operator new accounting against a nominal ESP32-S3 heap
+
+#ifndef HOST_ESP_H
+#define HOST_ESP_H
+
+#include <stdint.h>
+
+#define SIM_HEAP_SIZE (320 * 1024) // Free heap of the real board after boot, roughly
+
+class EspClass {
+  public:
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+    void restart();
+};
+
+extern EspClass ESP;
+
+#endif // HOST_ESP_H
@@ -0,0 +1,67 @@
+// FS.h - Host shim of the Arduino file API over an in-memory flash
+//
+// Behaves like SPIFFS where the firmware depends on it: seek() past the end of
+// a file fails, and writes fail (or come up short) once simFlashFree runs out
+// or simFlashFailWrites is set, so flash-full and write-error paths can be tested.
+
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+typedef std::vector<uint8_t> SimFileData;
+
+extern size_t simFlashFree;       // Bytes left on the simulated partition
+extern bool simFlashFailWrites;   // Every write fails while set
+extern uint32_t simFlashWrites;   // write() calls that stored at least one byte
+extern uint64_t simFlashReadBytes; // Bytes returned by read()
+
+class File {
+  public:
+    File() {}
+    File(std::shared_ptr<SimFileData> data, bool writable, bool append)
+        : data(data), writable(writable), pos(append ? data->size() : 0) {}
+
+    explicit operator bool() const { return data != nullptr; }
+    size_t size() const { return data ? data->size() : 0; }
+    size_t position() const { return pos; }
+    int available() { return data ? (int)(data->size() - pos) : 0; }
+    bool seek(uint32_t offset, SeekMode mode = SeekSet);
+    size_t read(uint8_t* buf, size_t size);
+    size_t write(const uint8_t* buf, size_t size);
+    size_t write(uint8_t c) { return write(&c, 1); }
+    void close() { data.reset(); }
+
+  private:
+    std::shared_ptr<SimFileData> data;
+    bool writable = false;
+    size_t pos = 0;
+};
+
+namespace fs {
+
+class FS {
+  public:
+    File open(const char* path, const char* mode = FILE_READ);
+    File open(const String& path, const char* mode = FILE_READ) { return open(path.c_str(), mode); }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+
+    std::map<std::string, std::shared_ptr<SimFileData>> files;
+};
+
+} // namespace fs
+
+#endif // HOST_FS_H
@@ -0,0 +1,73 @@
+// PubSubClient.h - Host shim of PubSubClient connected to an in-process broker stand-in
+//
+// simBroker records every publish with its virtual time, delivers injected
+// messages to subscribers from loop(), and echoes a client's own publishes on
+// topics it subscribed to (as a real broker does). While simBroker.up is false
+// the link is down: connected() is false, publishes fail and connect() fails
+// after blocking the calling task for connectBlockMs of virtual time.
+
+#ifndef HOST_PUBSUBCLIENT_H
+#define HOST_PUBSUBCLIENT_H
+
+#include <deque>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "WiFi.h"
+
+struct SimMessage {
+    std::string topic;
+    std::string payload;
+    uint64_t timeUs;          // Virtual time it reached the broker
+};
+
+struct SimBroker {
+    bool up = true;
+    unsigned long connectBlockMs = 2000;  // A refused TLS connect is not instant
+    std::vector<SimMessage> published;    // Everything the device published, in order
+    std::deque<SimMessage> inbound;       // Waiting for the device's next loop()
+    std::set<std::string> subscriptions;
+    uint32_t connects = 0;
+    uint32_t refusedPublishes = 0;
+    bool linkLost = false;                // The device's session was dropped by an outage
+
+    void setUp(bool isUp) {
+        if (!isUp) linkLost = true;
+        up = isUp;
+    }
+    // A message from another client (dashboard, HMI) on a topic
+    void inject(const std::string& topic, const std::string& payload);
+    size_t count(const std::string& topic, const char* contains = NULL) const;
+};
+
+extern SimBroker simBroker;
+
+class PubSubClient {
+  public:
+    typedef std::function<void(char*, uint8_t*, unsigned int)> Callback;
+
+    PubSubClient() {}
+    explicit PubSubClient(WiFiClient& client) { (void)client; }
+
+    PubSubClient& setServer(const char* domain, uint16_t port) { (void)domain; (void)port; return *this; }
+    PubSubClient& setCallback(Callback callback) { this->callback = callback; return *this; }
+    PubSubClient& setKeepAlive(uint16_t keepAlive) { (void)keepAlive; return *this; }
+    PubSubClient& setSocketTimeout(uint16_t timeout) { (void)timeout; return *this; }
+    bool setBufferSize(uint16_t size) { bufferSize = size; return true; }
+
+    bool connect(const char* id, const char* user, const char* pass);
+    bool connected();
+    bool loop();
+    bool subscribe(const char* topic);
+    bool publish(const char* topic, const uint8_t* payload, unsigned int length);
+    bool publish(const char* topic, const char* payload) { return publish(topic, (const uint8_t*)payload, strlen(payload)); }
+
+  private:
+    Callback callback;
+    uint16_t bufferSize = 256;
+    bool session = false;
+};
+
+#endif // HOST_PUBSUBCLIENT_H
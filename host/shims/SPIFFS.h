@@ -0,0 +1,15 @@
+// SPIFFS.h - Host shim: the SPIFFS partition is an in-memory fs::FS
+
+#ifndef HOST_SPIFFS_H
+#define HOST_SPIFFS_H
+
+#include "FS.h"
+
+class SPIFFSFS : public fs::FS {
+  public:
+    bool begin(bool formatOnFail = false) { (void)formatOnFail; return true; }
+};
+
+extern SPIFFSFS SPIFFS;
+
+#endif // HOST_SPIFFS_H
@@ -0,0 +1,72 @@
+// WString.h - Host shim of the Arduino String class
+//
+// Backed by std::string, so every String allocation goes through operator new
+// and shows up in the simulator's heap accounting like it would on the ESP32.
+
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+class String {
+  public:
+    String(const char* text = "") : s(text ? text : "") {}
+    String(const std::string& text) : s(text) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(unsigned char n, unsigned char base = 10) : s(number(n, base)) {}
+    explicit String(int n, unsigned char base = 10) : s(number(n, base)) {}
+    explicit String(unsigned int n, unsigned char base = 10) : s(number(n, base)) {}
+    explicit String(long n, unsigned char base = 10) : s(number(n, base)) {}
+    explicit String(unsigned long n, unsigned char base = 10) : s(number(n, base)) {}
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return s.size(); }
+    int toInt() const { return atoi(s.c_str()); }
+    int indexOf(const char* text) const {
+        size_t at = s.find(text);
+        return at == std::string::npos ? -1 : (int)at;
+    }
+    void toCharArray(char* buf, unsigned int size) const {
+        if (size == 0) return;
+        size_t n = s.size() < size - 1 ? s.size() : size - 1;
+        memcpy(buf, s.data(), n);
+        buf[n] = '\0';
+    }
+
+    String& operator+=(const String& other) { s += other.s; return *this; }
+    String& operator+=(const char* text) { s += text; return *this; }
+    bool operator==(const String& other) const { return s == other.s; }
+    bool operator==(const char* text) const { return s == text; }
+    bool operator!=(const String& other) const { return s != other.s; }
+    bool operator!=(const char* text) const { return s != text; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.s); }
+
+  private:
+    std::string s;
+
+    static std::string number(long n, unsigned char base) {
+        if (n < 0) return "-" + number((unsigned long)-n, base);
+        return number((unsigned long)n, base);
+    }
+    static std::string number(unsigned long n, unsigned char base) {
+        char digits[sizeof(unsigned long) * 8 + 1];
+        int pos = sizeof(digits) - 1;
+        digits[pos] = '\0';
+        do {
+            int d = n % base;
+            digits[--pos] = d < 10 ? '0' + d : 'a' + d - 10;
+            n /= base;
+        } while (n);
+        return digits + pos;
+    }
+    static std::string number(int n, unsigned char base) { return number((long)n, base); }
+    static std::string number(unsigned int n, unsigned char base) { return number((unsigned long)n, base); }
+    static std::string number(unsigned char n, unsigned char base) { return number((unsigned long)n, base); }
+};
+
+#endif // HOST_WSTRING_H
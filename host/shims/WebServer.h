@@ -0,0 +1,82 @@
+// WebServer.h - Host shim of the ESP32 WebServer
+//
+// Tests queue requests with simRequest(); handleClient() serves one per call
+// like the real server does per loop pass. As on the ESP32, a handler only sees
+// the request headers named in collectHeaders(). Responses are kept in
+// lastResponse; client() hands out the request's connection for streaming.
+
+#ifndef HOST_WEBSERVER_H
+#define HOST_WEBSERVER_H
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "FS.h"
+#include "WiFi.h"
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+struct SimResponse {
+    int code = 0;
+    std::string contentType;
+    std::map<std::string, std::string> headers;
+    std::string body;
+    size_t bytes = 0;         // Head and body bytes the firmware produced
+    bool streamed = false;    // The handler took the connection (client()) instead of responding
+};
+
+class WebServer {
+  public:
+    typedef std::function<void()> THandlerFunction;
+
+    explicit WebServer(int port = 80) { (void)port; }
+    void begin() {}
+    void on(const char* uri, HTTPMethod method, THandlerFunction handler);
+    void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+    void handleClient();
+
+    bool hasArg(const char* name);
+    String arg(const char* name);
+    bool hasHeader(const char* name);
+    String header(const char* name);
+    WiFiClient client() { return currentClient; }
+
+    void setContentLength(size_t length) { (void)length; }
+    void sendHeader(const char* name, const char* value, bool first = false);
+    void send(int code, const char* contentType = NULL, const String& content = String(""));
+    void sendContent(const char* content, size_t length);
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+    size_t streamFile(File& file, const String& contentType);
+
+    // Queue a request, e.g. simRequest("/events?since=5", {{"Cookie", "SESSIONID=1"}})
+    std::shared_ptr<SimConnection> simRequest(const std::string& url,
+                                              const std::map<std::string, std::string>& headers = {});
+    SimResponse lastResponse;
+    uint32_t requestsServed = 0;
+
+  private:
+    struct Route {
+        std::string uri;
+        HTTPMethod method;
+        THandlerFunction handler;
+    };
+    struct Request {
+        std::string path;
+        std::map<std::string, std::string> args;
+        std::map<std::string, std::string> headers;
+        std::shared_ptr<SimConnection> conn;
+    };
+
+    std::vector<Route> routes;
+    std::vector<std::string> collected;
+    std::deque<Request> pending;
+    Request current;
+    WiFiClient currentClient;
+};
+
+#endif // HOST_WEBSERVER_H
@@ -0,0 +1,69 @@
+// WiFi.h - Host shim of the ESP32 WiFi station and TCP client
+//
+// WiFi.status() follows simWiFiUp (sim.h). A WiFiClient is a handle on a
+// SimConnection shared by every copy of it, so a test holding the connection
+// sees what the firmware wrote and can close it like a browser would.
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <memory>
+#include <string>
+#include "Arduino.h"
+
+typedef enum { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 } wl_status_t;
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1 } wifi_mode_t;
+
+struct IPAddress {
+    uint8_t octets[4];
+    operator String() const;
+};
+
+class WiFiClass {
+  public:
+    bool mode(wifi_mode_t mode) { (void)mode; return true; }
+    wl_status_t begin(const char* ssid, const char* passphrase);
+    bool disconnect();
+    wl_status_t status();
+    IPAddress localIP();
+    IPAddress gatewayIP();
+};
+
+extern WiFiClass WiFi;
+
+// One TCP connection as seen from the far end
+struct SimConnection {
+    bool open = true;
+    bool capture = true;    // Keep the bytes in data (else only count them)
+    size_t bytes = 0;       // Bytes the firmware wrote
+    size_t writeLimit = (size_t)-1; // Bytes the socket accepts before writes fail (a stalled peer)
+    std::string data;
+};
+
+class WiFiClient : public Print {
+  public:
+    WiFiClient() {}
+    explicit WiFiClient(std::shared_ptr<SimConnection> conn) : conn(conn) {}
+
+    uint8_t connected() { return conn && conn->open; }
+    void stop() {
+        if (conn) conn->open = false;
+        conn.reset();
+    }
+    int setNoDelay(bool noDelay) { (void)noDelay; return 0; }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    explicit operator bool() { return connected(); }
+
+    std::shared_ptr<SimConnection> conn;
+};
+
+// Datagrams go nowhere; only the jitter test's load task sends any
+class WiFiUDP {
+  public:
+    int beginPacket(IPAddress ip, uint16_t port) { (void)ip; (void)port; return 1; }
+    size_t write(const uint8_t* buffer, size_t size) { (void)buffer; return size; }
+    int endPacket() { return 1; }
+};
+
+#endif // HOST_WIFI_H
@@ -0,0 +1,18 @@
+// WiFiClientSecure.h - Host shim: TLS is not simulated, the broker link is PubSubClient's fake
+
+#ifndef HOST_WIFICLIENTSECURE_H
+#define HOST_WIFICLIENTSECURE_H
+
+#include "WiFi.h"
+
+class WiFiClientSecure : public WiFiClient {
+  public:
+    void setCACert(const char* rootCA) { (void)rootCA; }
+    void setInsecure() {}
+    int connect(const char* host, uint16_t port, int32_t timeoutMs) {
+        (void)host; (void)port; (void)timeoutMs;
+        return 0;
+    }
+};
+
+#endif // HOST_WIFICLIENTSECURE_H
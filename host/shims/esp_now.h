@@ -0,0 +1,14 @@
+// esp_now.h - Host shim: only the receive callback's argument type
+
+#ifndef HOST_ESP_NOW_H
+#define HOST_ESP_NOW_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint8_t* src_addr;
+    uint8_t* des_addr;
+    void* rx_ctrl;
+} esp_now_recv_info_t;
+
+#endif // HOST_ESP_NOW_H
@@ -0,0 +1,8 @@
+// esp_task_wdt.h - Host shim: no watchdog in the simulator
+
+#ifndef HOST_ESP_TASK_WDT_H
+#define HOST_ESP_TASK_WDT_H
+
+static inline int esp_task_wdt_reset() { return 0; }
+
+#endif // HOST_ESP_TASK_WDT_H
@@ -0,0 +1,21 @@
+// freertos/FreeRTOS.h - Host shim: the simulator runs tasks as callbacks on its virtual clock
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define configMAX_PRIORITIES 25
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms) * configTICK_RATE_HZ / 1000)
+#define pdPASS 1
+#define pdFAIL 0
+
+#endif // HOST_FREERTOS_H
@@ -0,0 +1,492 @@
+// shims.cpp - Host implementations of the Arduino/ESP32 library shims
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPmDNS.h>
+#include <FS.h>
+#include <PubSubClient.h>
+#include <SPIFFS.h>
+#include <WebServer.h>
+#include <WiFi.h>
+
+#include "../sim.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+SPIFFSFS SPIFFS;
+MDNSResponder MDNS;
+SimBroker simBroker;
+
+size_t simFlashFree = 1408 * 1024; // Default 1.5 MB SPIFFS partition minus metadata
+bool simFlashFailWrites = false;
+uint32_t simFlashWrites = 0;
+uint64_t simFlashReadBytes = 0;
+
+// ===== Arduino core =====
+
+size_t Print::print(long n, int base) {
+    return print(String(n, base));
+}
+
+size_t Print::print(unsigned long n, int base) {
+    return print(String(n, base));
+}
+
+size_t Print::print(double n, int digits) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.*f", digits, n);
+    return print(text);
+}
+
+size_t Print::printf(const char* format, ...) {
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (len < 0) return 0;
+    return write((const uint8_t*)text, std::min((size_t)len, sizeof(text) - 1));
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    static bool echo = getenv("USF_SIM_SERIAL") != NULL;
+    if (echo) fwrite(buffer, 1, size, stdout);
+    return size;
+}
+
+long random(long howbig) {
+    return howbig > 0 ? rand() % howbig : 0;
+}
+
+long random(long howsmall, long howbig) {
+    return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+// Wall time starts at a fixed date once configTime() ran, and follows the virtual clock
+static bool timeConfigured = false;
+
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char* server1) {
+    (void)gmtOffset_sec; (void)daylightOffset_sec; (void)server1;
+    timeConfigured = true;
+}
+
+bool getLocalTime(struct tm* info, uint32_t ms) {
+    (void)ms;
+    if (!timeConfigured) return false;
+    time_t now = 1735689600 + (time_t)(simNowUs() / 1000000); // 2025-01-01 00:00:00
+    gmtime_r(&now, info);
+    return true;
+}
+
+// ===== ESP =====
+
+uint32_t EspClass::getFreeHeap() {
+    return SIM_HEAP_SIZE - (uint32_t)simHeap().used;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    return SIM_HEAP_SIZE - (uint32_t)simHeap().peak;
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+    return getFreeHeap() / 2; // The real heap is fragmented; not simulated
+}
+
+void EspClass::restart() {
+    fprintf(stderr, "sim: ESP.restart() called\n");
+    exit(3);
+}
+
+// ===== WiFi =====
+
+IPAddress::operator String() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(text);
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* passphrase) {
+    (void)ssid; (void)passphrase;
+    return status();
+}
+
+bool WiFiClass::disconnect() {
+    return true;
+}
+
+wl_status_t WiFiClass::status() {
+    return simWiFiUp ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+IPAddress WiFiClass::localIP() {
+    return IPAddress{{192, 168, 4, 2}};
+}
+
+IPAddress WiFiClass::gatewayIP() {
+    return IPAddress{{192, 168, 4, 1}};
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    if (!conn || !conn->open || !simWiFiUp) return 0;
+    if (conn->bytes + size > conn->writeLimit) return 0;
+    conn->bytes += size;
+    if (conn->capture) {
+        SimHostAlloc host;
+        conn->data.append((const char*)buffer, size);
+    }
+    return size;
+}
+
+// ===== File system =====
+
+bool File::seek(uint32_t offset, SeekMode mode) {
+    if (!data) return false;
+    size_t target = mode == SeekSet ? offset : mode == SeekCur ? pos + offset : data->size() + offset;
+    if (target > data->size()) return false; // SPIFFS cannot seek past the end
+    pos = target;
+    return true;
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+    if (!data || pos >= data->size()) return 0;
+    size_t n = std::min(size, data->size() - pos);
+    memcpy(buf, data->data() + pos, n);
+    pos += n;
+    simFlashReadBytes += n;
+    return n;
+}
+
+size_t File::write(const uint8_t* buf, size_t size) {
+    if (!data || !writable || simFlashFailWrites) return 0;
+    size_t growth = pos + size > data->size() ? pos + size - data->size() : 0;
+    if (growth > simFlashFree) {
+        // Partition full: store what fits, like a short SPIFFS write
+        size -= growth - simFlashFree;
+        growth = simFlashFree;
+    }
+    if (size == 0) return 0;
+    SimHostAlloc host;
+    if (growth) data->resize(data->size() + growth);
+    memcpy(data->data() + pos, buf, size);
+    pos += size;
+    simFlashFree -= growth;
+    simFlashWrites++;
+    return size;
+}
+
+namespace fs {
+
+File FS::open(const char* path, const char* mode) {
+    SimHostAlloc host;
+    auto it = files.find(path);
+    bool exists = it != files.end();
+    if (mode[0] == 'r' && !exists) return File();
+    if (!exists) it = files.emplace(path, std::make_shared<SimFileData>()).first;
+    if (mode[0] == 'w') {
+        simFlashFree += it->second->size();
+        it->second->clear();
+    }
+    bool writable = mode[0] != 'r' || mode[1] == '+';
+    return File(it->second, writable, mode[0] == 'a');
+}
+
+bool FS::exists(const char* path) {
+    SimHostAlloc host;
+    return files.count(path) > 0;
+}
+
+bool FS::remove(const char* path) {
+    SimHostAlloc host;
+    auto it = files.find(path);
+    if (it == files.end()) return false;
+    simFlashFree += it->second->size();
+    files.erase(it);
+    return true;
+}
+
+} // namespace fs
+
+// ===== WebServer =====
+
+static std::string urlDecode(const std::string& text) {
+    std::string out;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '%' && i + 2 < text.size()) {
+            out += (char)strtol(text.substr(i + 1, 2).c_str(), NULL, 16);
+            i += 2;
+        } else {
+            out += text[i] == '+' ? ' ' : text[i];
+        }
+    }
+    return out;
+}
+
+void WebServer::on(const char* uri, HTTPMethod method, THandlerFunction handler) {
+    SimHostAlloc host;
+    routes.push_back({uri, method, handler});
+}
+
+void WebServer::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+    SimHostAlloc host;
+    collected.clear();
+    for (size_t i = 0; i < headerKeysCount; i++) collected.push_back(headerKeys[i]);
+}
+
+std::shared_ptr<SimConnection> WebServer::simRequest(const std::string& url, const std::map<std::string, std::string>& headers) {
+    SimHostAlloc host;
+    Request request;
+    size_t query = url.find('?');
+    request.path = url.substr(0, query);
+    if (query != std::string::npos) {
+        std::string rest = url.substr(query + 1);
+        size_t start = 0;
+        while (start <= rest.size()) {
+            size_t end = rest.find('&', start);
+            if (end == std::string::npos) end = rest.size();
+            std::string pair = rest.substr(start, end - start);
+            size_t eq = pair.find('=');
+            if (!pair.empty()) {
+                request.args[urlDecode(pair.substr(0, eq))] = eq == std::string::npos ? "" : urlDecode(pair.substr(eq + 1));
+            }
+            start = end + 1;
+        }
+    }
+    request.headers = headers;
+    request.conn = std::make_shared<SimConnection>();
+    pending.push_back(request);
+    return request.conn;
+}
+
+void WebServer::handleClient() {
+    if (pending.empty()) return;
+    {
+        SimHostAlloc host;
+        current = pending.front();
+        pending.pop_front();
+        // Like the real server, keep only the headers the sketch asked for
+        std::map<std::string, std::string> kept;
+        for (const std::string& name : collected) {
+            auto it = current.headers.find(name);
+            if (it != current.headers.end()) kept[name] = it->second;
+        }
+        current.headers = kept;
+        lastResponse = SimResponse();
+        currentClient = WiFiClient(current.conn);
+    }
+    requestsServed++;
+    bool routed = false;
+    for (const Route& route : routes) {
+        if (route.uri == current.path && (route.method == HTTP_ANY || route.method == HTTP_GET)) {
+            route.handler();
+            routed = true;
+            break;
+        }
+    }
+    SimHostAlloc host;
+    if (!routed) send(404, "text/plain", "Not found");
+    lastResponse.streamed = current.conn->bytes > 0;
+    if (!lastResponse.streamed) current.conn->open = false;
+    currentClient = WiFiClient();
+}
+
+bool WebServer::hasArg(const char* name) {
+    SimHostAlloc host;
+    return current.args.count(name) > 0;
+}
+
+String WebServer::arg(const char* name) {
+    std::string value;
+    {
+        SimHostAlloc host;
+        auto it = current.args.find(name);
+        if (it != current.args.end()) value = it->second;
+    }
+    return String(value.c_str());
+}
+
+bool WebServer::hasHeader(const char* name) {
+    SimHostAlloc host;
+    return current.headers.count(name) > 0;
+}
+
+String WebServer::header(const char* name) {
+    std::string value;
+    {
+        SimHostAlloc host;
+        auto it = current.headers.find(name);
+        if (it != current.headers.end()) value = it->second;
+    }
+    return String(value.c_str());
+}
+
+void WebServer::sendHeader(const char* name, const char* value, bool first) {
+    (void)first;
+    SimHostAlloc host;
+    lastResponse.headers[name] = value;
+}
+
+void WebServer::send(int code, const char* contentType, const String& content) {
+    SimHostAlloc host;
+    lastResponse.code = code;
+    lastResponse.contentType = contentType ? contentType : "";
+    lastResponse.body.append(content.c_str(), content.length());
+    lastResponse.bytes += 64 + content.length(); // Status line and standard headers, roughly
+}
+
+void WebServer::sendContent(const char* content, size_t length) {
+    SimHostAlloc host;
+    lastResponse.body.append(content, length);
+    lastResponse.bytes += length;
+}
+
+size_t WebServer::streamFile(File& file, const String& contentType) {
+    uint8_t chunk[256];
+    size_t total = 0;
+    send(200, contentType.c_str(), "");
+    size_t n;
+    while ((n = file.read(chunk, sizeof(chunk))) > 0) {
+        sendContent((const char*)chunk, n);
+        total += n;
+    }
+    return total;
+}
+
+// ===== PubSubClient =====
+
+void SimBroker::inject(const std::string& topic, const std::string& payload) {
+    SimHostAlloc host;
+    inbound.push_back({topic, payload, simNowUs()});
+}
+
+size_t SimBroker::count(const std::string& topic, const char* contains) const {
+    size_t n = 0;
+    for (const SimMessage& message : published) {
+        if (message.topic == topic && (!contains || message.payload.find(contains) != std::string::npos)) n++;
+    }
+    return n;
+}
+
+bool PubSubClient::connect(const char* id, const char* user, const char* pass) {
+    (void)id; (void)user; (void)pass;
+    if (!simWiFiUp || !simBroker.up) {
+        simAdvanceUs((uint64_t)simBroker.connectBlockMs * 1000);
+        return false;
+    }
+    SimHostAlloc host;
+    simBroker.linkLost = false;
+    simBroker.subscriptions.clear();
+    simBroker.connects++;
+    session = true;
+    return true;
+}
+
+bool PubSubClient::connected() {
+    if (simBroker.linkLost || !simBroker.up || !simWiFiUp) session = false;
+    return session;
+}
+
+bool PubSubClient::loop() {
+    if (!connected()) return false;
+    while (!simBroker.inbound.empty()) {
+        SimMessage message;
+        {
+            SimHostAlloc host;
+            message = simBroker.inbound.front();
+            simBroker.inbound.pop_front();
+        }
+        if (!simBroker.subscriptions.count(message.topic) || !callback) continue;
+        // The real client hands out its receive buffer, so these are not firmware allocations
+        std::vector<char> topic;
+        {
+            SimHostAlloc host;
+            topic.assign(message.topic.begin(), message.topic.end());
+            topic.push_back('\0');
+        }
+        callback(topic.data(), (uint8_t*)&message.payload[0], message.payload.size());
+    }
+    return true;
+}
+
+bool PubSubClient::subscribe(const char* topic) {
+    if (!connected()) return false;
+    SimHostAlloc host;
+    simBroker.subscriptions.insert(topic);
+    return true;
+}
+
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int length) {
+    if (!connected()) {
+        simBroker.refusedPublishes++;
+        return false;
+    }
+    if (length + strlen(topic) + 7 > bufferSize) return false; // Does not fit the client's buffer
+    SimHostAlloc host;
+    SimMessage message = {topic, std::string((const char*)payload, length), simNowUs()};
+    simBroker.published.push_back(message);
+    if (simBroker.subscriptions.count(topic)) simBroker.inbound.push_back(message);
+    return true;
+}
+
+// ===== ArduinoJson =====
+
+static bool parseJsonString(const char*& p, std::string& out) {
+    if (*p != '"') return false;
+    for (p++; *p && *p != '"'; p++) {
+        if (*p == '\\') {
+            p++;
+            switch (*p) {
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': out += '?'; p += 4; break;
+                case '\0': return false;
+                default: out += *p; break;
+            }
+        } else {
+            out += *p;
+        }
+    }
+    if (*p != '"') return false;
+    p++;
+    return true;
+}
+
+static void skipSpaces(const char*& p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+}
+
+DeserializationError deserializeJson(JsonDocument& doc, const char* input) {
+    SimHostAlloc host;
+    doc.strings.clear();
+    const char* p = input;
+    skipSpaces(p);
+    if (*p++ != '{') return DeserializationError::InvalidInput;
+    skipSpaces(p);
+    if (*p == '}') return DeserializationError::Ok;
+    for (;;) {
+        std::string key, value;
+        skipSpaces(p);
+        if (!parseJsonString(p, key)) return DeserializationError::InvalidInput;
+        skipSpaces(p);
+        if (*p++ != ':') return DeserializationError::InvalidInput;
+        skipSpaces(p);
+        if (*p == '"') {
+            if (!parseJsonString(p, value)) return DeserializationError::InvalidInput;
+            doc.strings[key] = value;
+        } else {
+            // Numbers, true/false/null: skipped (nested values are not supported)
+            while (*p && *p != ',' && *p != '}') {
+                if (*p == '{' || *p == '[') return DeserializationError::InvalidInput;
+                p++;
+            }
+        }
+        skipSpaces(p);
+        if (*p == ',') {
+            p++;
+            continue;
+        }
+        if (*p == '}') return DeserializationError::Ok;
+        return DeserializationError::InvalidInput;
+    }
+}
@@ -0,0 +1,308 @@
+// sim.cpp - Simulator core: clock, GPIO, scheduling and heap accounting (see sim.h)
+
+#include "sim.h"
+
+#include <chrono>
+#include <map>
+#include <new>
+#include <algorithm>
+#include <Arduino.h>
+
+// Provided by the sketch
+void setup();
+void loop();
+void runIoCycle();
+
+#define SIM_PINS 64
+#define SIM_IO_PERIOD_US 5000 // IO_TASK_PERIOD_MS
+
+static uint64_t nowUs = 0;
+static uint64_t nextIoCycleUs = 0;
+static bool ioTaskStarted = false;
+static bool inIoCycle = false;
+
+struct SimPin {
+    int level = 0;
+    uint8_t mode = 0;
+    void (*isr)(void*) = nullptr;
+    void* isrArg = nullptr;
+};
+static SimPin pins[SIM_PINS];
+static std::multimap<uint64_t, std::pair<uint8_t, int>> scheduledEdges;
+static std::function<void(uint8_t, int)> pinWriteHook;
+
+bool simWiFiUp = true;
+uint64_t simLoopIntervalUs = 1000;
+std::vector<uint32_t> simLoopNs;
+std::vector<uint32_t> simIoCycleNs;
+
+// ===== Heap =====
+// Every block carries a header saying whether it was counted, so blocks the
+// simulator allocated can be freed by firmware code and the other way round.
+struct alignas(16) BlockHeader {
+    size_t size;
+    bool counted;
+};
+
+static int hostAllocDepth = 0;
+static bool firmwareActive = false;
+static SimHeapStats heapStats = {0, 0, 0, 0};
+
+SimHostAlloc::SimHostAlloc() {
+    hostAllocDepth++;
+}
+
+SimHostAlloc::~SimHostAlloc() {
+    hostAllocDepth--;
+}
+
+static void* trackedAlloc(size_t size) {
+    BlockHeader* header = (BlockHeader*)malloc(sizeof(BlockHeader) + size);
+    if (!header) throw std::bad_alloc();
+    header->size = size;
+    header->counted = firmwareActive && hostAllocDepth == 0;
+    if (header->counted) {
+        heapStats.used += size;
+        heapStats.peak = std::max(heapStats.peak, heapStats.used);
+        heapStats.allocs++;
+        heapStats.allocBytes += size;
+    }
+    return header + 1;
+}
+
+static void trackedFree(void* ptr) {
+    if (!ptr) return;
+    BlockHeader* header = (BlockHeader*)ptr - 1;
+    if (header->counted) heapStats.used -= header->size;
+    free(header);
+}
+
+void* operator new(size_t size) { return trackedAlloc(size); }
+void* operator new[](size_t size) { return trackedAlloc(size); }
+void operator delete(void* ptr) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { trackedFree(ptr); }
+
+SimHeapStats simHeap() {
+    return heapStats;
+}
+
+void simHeapReset() {
+    heapStats.peak = heapStats.used;
+    heapStats.allocs = 0;
+    heapStats.allocBytes = 0;
+}
+
+SimFirmwareScope::SimFirmwareScope() : outer(!firmwareActive) {
+    firmwareActive = true;
+}
+
+SimFirmwareScope::~SimFirmwareScope() {
+    if (outer) firmwareActive = false;
+}
+
+// ===== Clock and scheduling =====
+
+static uint32_t elapsedNs(std::chrono::steady_clock::time_point start) {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void runIoCycleAt(uint64_t atUs) {
+    nowUs = atUs;
+    inIoCycle = true;
+    auto start = std::chrono::steady_clock::now();
+    {
+        SimFirmwareScope scope;
+        runIoCycle();
+    }
+    uint32_t ns = elapsedNs(start);
+    SimHostAlloc host;
+    simIoCycleNs.push_back(ns);
+    inIoCycle = false;
+}
+
+uint64_t simNowUs() {
+    return nowUs;
+}
+
+void simAdvanceUs(uint64_t us) {
+    uint64_t end = nowUs + us;
+    for (;;) {
+        uint64_t nextEdge = scheduledEdges.empty() ? UINT64_MAX : scheduledEdges.begin()->first;
+        uint64_t nextIo = ioTaskStarted && !inIoCycle ? nextIoCycleUs : UINT64_MAX;
+        uint64_t next = std::min(nextEdge, nextIo);
+        if (next > end) break;
+        if (nextEdge <= nextIo) {
+            auto edge = scheduledEdges.begin()->second;
+            nowUs = nextEdge;
+            scheduledEdges.erase(scheduledEdges.begin());
+            simSetPin(edge.first, edge.second);
+        } else {
+            runIoCycleAt(nextIo);
+            nextIoCycleUs += SIM_IO_PERIOD_US;
+        }
+    }
+    nowUs = end;
+}
+
+void simBoot() {
+    SimFirmwareScope scope;
+    setup();
+}
+
+void simRun(uint64_t us) {
+    uint64_t end = nowUs + us;
+    while (nowUs < end) {
+        auto start = std::chrono::steady_clock::now();
+        {
+            SimFirmwareScope scope;
+            loop();
+        }
+        uint32_t ns = elapsedNs(start);
+        {
+            SimHostAlloc host;
+            simLoopNs.push_back(ns);
+        }
+        if (nowUs < end) simAdvanceUs(std::min(simLoopIntervalUs, end - nowUs));
+    }
+}
+
+bool simIoTaskStarted() {
+    return ioTaskStarted;
+}
+
+uint32_t simPercentile(std::vector<uint32_t> values, double percent) {
+    if (values.empty()) return 0;
+    size_t rank = (size_t)(percent / 100.0 * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+// ===== GPIO =====
+
+void simSetPin(uint8_t pin, int level) {
+    SimPin& p = pins[pin % SIM_PINS];
+    if (p.level == level) return;
+    p.level = level;
+    if (p.isr) {
+        SimFirmwareScope scope;
+        p.isr(p.isrArg);
+    }
+}
+
+void simSchedulePin(uint8_t pin, int level, uint64_t atUs) {
+    SimHostAlloc host;
+    scheduledEdges.emplace(atUs, std::make_pair(pin, level));
+}
+
+int simPinLevel(uint8_t pin) {
+    return pins[pin % SIM_PINS].level;
+}
+
+void simOnPinWrite(std::function<void(uint8_t pin, int level)> hook) {
+    SimHostAlloc host;
+    pinWriteHook = hook;
+}
+
+// ===== HAL (MOTOR_HAL_EXTERNAL) =====
+
+unsigned long halMillis() {
+    return (unsigned long)(nowUs / 1000);
+}
+
+unsigned long halMicros() {
+    return (unsigned long)nowUs;
+}
+
+int halDigitalRead(uint8_t pin) {
+    return pins[pin % SIM_PINS].level;
+}
+
+void halDigitalWrite(uint8_t pin, uint8_t level) {
+    SimPin& p = pins[pin % SIM_PINS];
+    bool changed = p.level != level;
+    p.level = level;
+    if (changed && pinWriteHook) {
+        SimHostAlloc host;
+        pinWriteHook(pin, level);
+    }
+}
+
+void halPinMode(uint8_t pin, uint8_t mode) {
+    SimPin& p = pins[pin % SIM_PINS];
+    p.mode = mode;
+    if (mode == INPUT_PULLUP) p.level = HIGH;
+}
+
+void halAttachEdgeInterrupt(uint8_t pin, void (*isr)(void*), void* arg) {
+    SimPin& p = pins[pin % SIM_PINS];
+    p.isr = isr;
+    p.isrArg = arg;
+}
+
+// ===== Arduino core and FreeRTOS on the virtual clock =====
+
+unsigned long millis() {
+    return halMillis();
+}
+
+unsigned long micros() {
+    return halMicros();
+}
+
+void delay(unsigned long ms) {
+    simAdvanceUs((uint64_t)ms * 1000);
+}
+
+void yield() {
+}
+
+int digitalRead(uint8_t pin) {
+    return halDigitalRead(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+    halDigitalWrite(pin, level);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    halPinMode(pin, mode);
+}
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode) {
+    (void)mode;
+    halAttachEdgeInterrupt(pin, isr, arg);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stackDepth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    (void)task; (void)name; (void)arg; (void)priority; (void)core;
+    // The only task the sketch creates is the I/O task; its body is runIoCycle()
+    ioTaskStarted = true;
+    nextIoCycleUs = nowUs + SIM_IO_PERIOD_US;
+    if (handle) *handle = (TaskHandle_t)(uintptr_t)stackDepth;
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return (TaskHandle_t)(uintptr_t)8192; // Arduino loop task stack
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)halMillis();
+}
+
+void vTaskDelay(TickType_t ticks) {
+    simAdvanceUs((uint64_t)ticks * 1000);
+}
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t period) {
+    *previousWake += period;
+    if (*previousWake > xTaskGetTickCount()) simAdvanceUs((uint64_t)(*previousWake - xTaskGetTickCount()) * 1000);
+}
+
+// Stacks are not simulated: report the whole stack as never used
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    return (UBaseType_t)(uintptr_t)task;
+}
@@ -0,0 +1,68 @@
+// sim.h - Virtual clock, simulated GPIO and task scheduling for the motor firmware on Linux
+//
+// The firmware is built with MOTOR_HAL_EXTERNAL, so its halMillis()/halMicros()/
+// halDigital*() calls land here. Time only moves when the simulator moves it:
+// - simRun() alternates loop() passes with the 5 ms I/O task cycle
+// - Anything that blocks the loop (delay(), a refused broker connect) advances
+//   the clock through simAdvanceUs(), which keeps the I/O cycle and scheduled pin
+//   edges running, like the other core would
+// - Driving an input calls the edge ISR the firmware attached to it
+// Heap use is tracked through operator new, counting firmware allocations only.
+
+#ifndef HOST_SIM_H
+#define HOST_SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <vector>
+
+// ===== Clock =====
+uint64_t simNowUs();
+void simAdvanceUs(uint64_t us);   // Fires due pin edges and I/O cycles, not loop()
+
+// ===== GPIO =====
+void simSetPin(uint8_t pin, int level);                    // Drive an input now
+void simSchedulePin(uint8_t pin, int level, uint64_t atUs); // Drive an input later
+int simPinLevel(uint8_t pin);
+// Called for every level change the firmware writes to an output
+void simOnPinWrite(std::function<void(uint8_t pin, int level)> hook);
+
+// ===== Network =====
+extern bool simWiFiUp;
+
+// ===== Tasks =====
+extern uint64_t simLoopIntervalUs;    // Virtual time between two loop() passes
+void simBoot();                       // setup(), which also starts the I/O task
+void simRun(uint64_t us);             // loop() and the I/O task for us of virtual time
+bool simIoTaskStarted();
+
+// Host CPU time of each loop() pass and I/O cycle (ns), for percentiles
+extern std::vector<uint32_t> simLoopNs;
+extern std::vector<uint32_t> simIoCycleNs;
+uint32_t simPercentile(std::vector<uint32_t> values, double percent);
+
+// ===== Heap =====
+struct SimHeapStats {
+    size_t used;         // Firmware bytes allocated now
+    size_t peak;         // High-water mark of used
+    uint64_t allocs;     // Allocations since the last simHeapReset()
+    uint64_t allocBytes; // Bytes of those allocations
+};
+SimHeapStats simHeap();
+void simHeapReset();      // Restart peak/allocs/allocBytes from the current use
+
+// Allocations made while one of these is alive belong to the simulator, not the firmware
+struct SimHostAlloc {
+    SimHostAlloc();
+    ~SimHostAlloc();
+};
+
+// Marks a direct call into firmware code (simRun() and the ISRs already do)
+struct SimFirmwareScope {
+    bool outer;
+    SimFirmwareScope();
+    ~SimFirmwareScope();
+};
+
+#endif // HOST_SIM_H
@@ -0,0 +1,179 @@
+// sketch_prep.cpp - Turns MotorESP32S3.ino into a C++ file the way the Arduino builder does
+//
+// Usage: sketch_prep <sketch.ino> <out.cpp>
+// - Adds #include <Arduino.h> at the top
+// - Inserts a prototype for every top-level function right before the first
+//   function definition, so functions can be called before they are defined
+// - #line directives keep compiler messages pointing at the .ino
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Top-level declaration text collected between two statement boundaries
+struct Declaration {
+    std::string text; // Code only: comments, strings and preprocessor lines removed
+    int line;         // Line of its first character
+};
+
+static bool startsWithWord(const std::string& text, const char* word) {
+    size_t n = strlen(word);
+    return text.compare(0, n, word) == 0 && (text.size() == n || !(isalnum((unsigned char)text[n]) || text[n] == '_'));
+}
+
+static std::string collapseSpaces(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (isspace((unsigned char)c)) {
+            if (!out.empty() && out.back() != ' ') out += ' ';
+        } else {
+            out += c;
+        }
+    }
+    while (!out.empty() && out.back() == ' ') out.pop_back();
+    return out;
+}
+
+// Prototype for a function definition head "type name(args)", empty for anything else
+static std::string functionPrototype(const std::string& raw) {
+    std::string text = collapseSpaces(raw);
+    if (text.empty() || text.back() != ')') return "";
+    const char* skip[] = {"struct", "class", "enum", "union", "namespace", "typedef", "template", "extern"};
+    for (const char* word : skip) {
+        if (startsWithWord(text, word)) return "";
+    }
+    size_t open = text.find('(');
+    if (open == std::string::npos || text.find('=') < open) return "";
+
+    // Drop default arguments: the definition keeps them
+    std::string out;
+    int depth = 0;
+    bool dropping = false;
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        if (c == '(') depth++;
+        if (c == ')') depth--;
+        if (depth == 1 && c == '=' && i > open) dropping = true;
+        if (dropping && ((depth == 1 && c == ',') || depth == 0)) dropping = false;
+        if (!dropping) out += c;
+    }
+    return collapseSpaces(out) + ";";
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <sketch.ino> <out.cpp>\n", argv[0]);
+        return 2;
+    }
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        fprintf(stderr, "sketch_prep: cannot read %s\n", argv[1]);
+        return 1;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string src = buffer.str();
+
+    // One pass over the source at brace depth 0
+    std::vector<std::string> prototypes;
+    int firstFunctionLine = 0;
+    Declaration current = {"", 0};
+    int depth = 0;
+    int line = 1;
+    bool lineStart = true;
+    for (size_t i = 0; i < src.size(); i++) {
+        char c = src[i];
+        if (c == '\n') {
+            line++;
+            lineStart = true;
+            if (depth == 0 && !current.text.empty()) current.text += ' ';
+            continue;
+        }
+        if (lineStart && c == '#') {
+            // Preprocessor line (with continuations): not part of any declaration
+            while (i < src.size() && !(src[i] == '\n' && src[i - 1] != '\\')) {
+                if (src[i] == '\n') line++;
+                i++;
+            }
+            line++;
+            lineStart = true;
+            continue;
+        }
+        if (!isspace((unsigned char)c)) lineStart = false;
+
+        if (c == '/' && i + 1 < src.size() && src[i + 1] == '/') {
+            while (i + 1 < src.size() && src[i + 1] != '\n') i++;
+            continue;
+        }
+        if (c == '/' && i + 1 < src.size() && src[i + 1] == '*') {
+            for (i += 2; i + 1 < src.size() && !(src[i] == '*' && src[i + 1] == '/'); i++) {
+                if (src[i] == '\n') line++;
+            }
+            i++;
+            continue;
+        }
+        if (c == 'R' && i + 1 < src.size() && src[i + 1] == '"') {
+            // Raw string literal R"delim( ... )delim"
+            size_t paren = src.find('(', i + 2);
+            std::string close = ")" + src.substr(i + 2, paren - i - 2) + "\"";
+            size_t end = src.find(close, paren);
+            for (size_t k = i; k < end; k++) {
+                if (src[k] == '\n') line++;
+            }
+            i = end + close.size() - 1;
+            if (depth == 0) current.text += "\"\"";
+            continue;
+        }
+        if (c == '"' || c == '\'') {
+            for (i++; i < src.size() && src[i] != c; i++) {
+                if (src[i] == '\\') i++;
+            }
+            if (depth == 0) current.text += "\"\"";
+            continue;
+        }
+
+        if (depth == 0) {
+            if (c == ';') {
+                current.text.clear();
+                continue;
+            }
+            if (c == '{') {
+                std::string prototype = functionPrototype(current.text);
+                if (!prototype.empty()) {
+                    if (firstFunctionLine == 0) firstFunctionLine = current.line;
+                    prototypes.push_back(prototype);
+                }
+                current.text.clear();
+                depth++;
+                continue;
+            }
+            if (!isspace((unsigned char)c) && current.text.find_first_not_of(' ') == std::string::npos) {
+                current.text.clear();
+                current.line = line;
+            }
+            current.text += c;
+        } else if (c == '{') {
+            depth++;
+        } else if (c == '}') {
+            depth--;
+            if (depth == 0) current.text.clear();
+        }
+    }
+
+    std::ofstream out(argv[2], std::ios::binary);
+    out << "#include <Arduino.h>\n#line 1 \"" << argv[1] << "\"\n";
+    std::istringstream lines(src);
+    std::string text;
+    for (int n = 1; std::getline(lines, text); n++) {
+        if (n == firstFunctionLine) {
+            for (const std::string& prototype : prototypes) out << prototype << "\n";
+            out << "#line " << n << " \"" << argv[1] << "\"\n";
+        }
+        out << text << "\n";
+    }
+    return out ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+// status_stream_test.cpp - /getStatus and /stream cursors, and a multi-client benchmark
+//
+// A cursor from before a reboot can be ahead of the log; both endpoints must
+// answer it with a snapshot, not an empty delta. The benchmark keeps
+// STREAM_MAX_CLIENTS SSE clients open through a minute of LED and log churn and
+// reports the bytes each one receives per second and the firmware heap, next to
+// the same clients polling /getStatus once a second.
+
+#include "MotorESP32S3.cpp"
+#include "sim.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-60s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static std::map<std::string, std::string> session(const char* lastEventId = NULL) {
+    std::map<std::string, std::string> headers = {{"Cookie", "SESSIONID=1"}};
+    if (lastEventId) headers["Last-Event-ID"] = lastEventId;
+    return headers;
+}
+
+static const SimResponse& get(const std::string& url) {
+    uint32_t served = server.requestsServed;
+    server.simRequest(url, session());
+    while (server.requestsServed == served) simRun(1000);
+    return server.lastResponse;
+}
+
+static std::shared_ptr<SimConnection> openStream(const char* lastEventId) {
+    uint32_t served = server.requestsServed;
+    std::shared_ptr<SimConnection> conn = server.simRequest("/stream", session(lastEventId));
+    while (server.requestsServed == served) simRun(1000);
+    return conn;
+}
+
+static bool has(const std::string& text, const char* what) {
+    return text.find(what) != std::string::npos;
+}
+
+static void cursorAhead() {
+    printf("cursor ahead of the log (client kept it across a reboot)\n");
+    {
+        SimFirmwareScope scope;
+        logEvent(EVENT_ALARM, ALARM_R10, 0x0700);
+        addToLog("before the cursor check");
+        flushLogBuffer();
+    }
+    char ahead[40];
+    StatusCursor future = {eventLogNewestSeq + 100, serialLogsTotal, configRevision};
+    formatStatusCursor(ahead, sizeof(ahead), future);
+    const SimResponse& events = get(std::string("/getStatus?since=") + ahead);
+    check(events.code == 200 && !has(events.body, "\"delta\"") && has(events.body, "ledStatusHistory"),
+          "/getStatus?since= event seq ahead: snapshot");
+
+    StatusCursor longer = {eventLogNewestSeq, serialLogsTotal + 5000, configRevision};
+    formatStatusCursor(ahead, sizeof(ahead), longer);
+    const SimResponse& logs = get(std::string("/getStatus?since=") + ahead);
+    check(logs.code == 200 && !has(logs.body, "\"delta\"") && has(logs.body, "before the cursor check"),
+          "/getStatus?since= log bytes ahead: snapshot with the logs");
+
+    std::shared_ptr<SimConnection> conn = openStream(ahead);
+    check(has(conn->data, "event: snapshot") && !has(conn->data, "event: delta"),
+          "/stream Last-Event-ID ahead: snapshot event");
+    char current[40];
+    formatStatusCursor(current, sizeof(current), currentStatusCursor());
+    check(has(conn->data, (std::string("id: ") + current).c_str()), "and the client's cursor is reset to now");
+    conn->open = false;
+
+    StatusCursor behind = currentStatusCursor();
+    behind.eventSeq--;
+    formatStatusCursor(current, sizeof(current), behind);
+    conn = openStream(current);
+    check(has(conn->data, "event: delta"), "/stream Last-Event-ID behind: still a delta");
+    conn->open = false;
+    simRun(STREAM_PUSH_INTERVAL * 1000);
+}
+
+// One LED change and two log lines a second, the churn of a lift in use. The
+// log lines are built outside the firmware scope so only the server's own
+// allocations are counted.
+static void churn(int second) {
+    char line[64];
+    snprintf(line, sizeof(line), "churn %d: motor current nominal", second);
+    String current(line), position("lift position updated");
+    SimFirmwareScope scope;
+    logEvent(second % 10 == 0 ? EVENT_ALARM : EVENT_LED_CHANGE, second % 10 == 0 ? ALARM_A14 : ALARM_NONE,
+             (uint16_t)second);
+    addToLog(current);
+    addToLog(position);
+}
+
+static void benchmark() {
+    const int seconds = 60;
+    const int clients = STREAM_MAX_CLIENTS;
+    printf("benchmark: %d clients, %d s of churn\n", clients, seconds);
+
+    // SSE: one stream per client, deltas pushed every STREAM_PUSH_INTERVAL
+    std::vector<std::shared_ptr<SimConnection>> streams;
+    simHeapReset();
+    size_t heapBefore = simHeap().used;
+    for (int i = 0; i < clients; i++) {
+        streams.push_back(openStream(NULL));
+        streams.back()->capture = false;
+    }
+    std::vector<size_t> opened;
+    for (const auto& conn : streams) opened.push_back(conn->bytes);
+    for (int second = 0; second < seconds; second++) {
+        churn(second);
+        simRun(1000 * 1000);
+    }
+    SimHeapStats heap = simHeap();
+    size_t streamBytes = 0;
+    bool allOpen = true;
+    for (size_t i = 0; i < streams.size(); i++) {
+        streamBytes += streams[i]->bytes - opened[i];
+        allOpen = allOpen && streams[i]->open;
+        streams[i]->open = false;
+    }
+    simRun(STREAM_PUSH_INTERVAL * 1000);
+    double streamRate = (double)streamBytes / clients / seconds;
+    printf("  /stream         %8.0f B/s per client, heap peak +%zu B, %llu allocations\n", streamRate,
+           heap.peak - heapBefore, (unsigned long long)heap.allocs);
+    check(allOpen, "all streams stayed open");
+    check(heap.allocs == 0, "pushing deltas to every client allocates nothing");
+
+    // Polling: every client fetches a full snapshot once a second
+    simHeapReset();
+    heapBefore = simHeap().used;
+    size_t pollBytes = 0;
+    for (int second = 0; second < seconds; second++) {
+        churn(second);
+        for (int i = 0; i < clients; i++) pollBytes += get("/getStatus").body.size();
+        simRun(1000 * 1000);
+    }
+    heap = simHeap();
+    double pollRate = (double)pollBytes / clients / seconds;
+    printf("  /getStatus poll %8.0f B/s per client, heap peak +%zu B, %llu allocations\n", pollRate,
+           heap.peak - heapBefore, (unsigned long long)heap.allocs);
+    check(streamRate * 4 < pollRate, "stream deltas send under a quarter of snapshot polling");
+}
+
+int main() {
+    simBoot();
+    simRun(2000 * 1000);
+    cursorAhead();
+    benchmark();
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+// wire_bench.c - usf_wire.h frames against the JSON they replace: bytes and parse time
+//
+// Messages are the ones the HMI and motor exchange: a command as send_mqtt()
+// enqueues it and an alert as the motor publishes it. JSON is parsed with the
+// cJSON in host/cjson/, the library the HMI links on the device. Host times only
+// compare runs on the same machine.
+
+#include "usf_wire.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cJSON.h"
+
+#define BENCH_FRAME_VIEWS 50000000
+#define BENCH_JSON_PARSES 1000000
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("  %-60s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static uint64_t host_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+
+static const char command_json[] =
+    "{\"type\":\"command\",\"message\":\"COMMAND:UP\",\"timestamp\":\"2026-10-17T12:00:00\"}";
+static const char alert_json[] =
+    "{\"type\":\"red\",\"message\":\"R10 - Final Limit\",\"led_code\":\"1110-0000\","
+    "\"timestamp\":\"2026-10-17 12:00:00\"}";
+
+static double frame_view_ns(void) {
+    usf_frame_t frame;
+    usf_frame_init(&frame, USF_MSG_ALARM, 0, 123456);
+    frame.alarm_level = USF_LEVEL_RED;
+    memcpy(frame.alarm_code, "R10", 3);
+    uint8_t wire[40];
+    memcpy(wire + 1, &frame, sizeof(frame)); // Odd offset, as in an MQTT buffer
+    volatile uint32_t sink = 0;
+    uint64_t start = host_ns();
+    for (uint32_t i = 0; i < BENCH_FRAME_VIEWS; i++) {
+        wire[5] = (uint8_t)i; // seq, so the view is not hoisted out of the loop
+        const usf_frame_t *view = usf_frame_view(wire + 1, sizeof(frame));
+        sink += view->seq + view->led_pattern + view->alarm_level + view->alarm_code[0];
+    }
+    return (double)(host_ns() - start) / BENCH_FRAME_VIEWS;
+}
+
+// The HMI's handle_json_message(): parse in place, read the three fields
+static bool read_json(const char *data, size_t len) {
+    cJSON *root = cJSON_ParseWithLength(data, len);
+    if (!root) return false;
+    bool ok = cJSON_IsString(cJSON_GetObjectItem(root, "type")) &&
+              cJSON_IsString(cJSON_GetObjectItem(root, "message")) &&
+              cJSON_IsString(cJSON_GetObjectItem(root, "timestamp"));
+    cJSON_Delete(root);
+    return ok;
+}
+
+// What it replaced: a strndup() copy of every message, then cJSON_Parse()
+static bool read_json_copy(const char *data, size_t len) {
+    char *copy = strndup(data, len);
+    cJSON *root = cJSON_Parse(copy);
+    bool ok = root && cJSON_IsString(cJSON_GetObjectItem(root, "message"));
+    cJSON_Delete(root);
+    free(copy);
+    return ok;
+}
+
+static double json_ns(bool (*read)(const char *, size_t), const char *json) {
+    size_t len = strlen(json);
+    uint32_t ok = 0;
+    uint64_t start = host_ns();
+    for (uint32_t i = 0; i < BENCH_JSON_PARSES; i++) ok += read(json, len);
+    double ns = (double)(host_ns() - start) / BENCH_JSON_PARSES;
+    return ok == BENCH_JSON_PARSES ? ns : -1;
+}
+
+int main(void) {
+    printf("bytes per message\n");
+    printf("  command  %3zu B JSON, %d B frame\n", strlen(command_json), USF_FRAME_V1_SIZE);
+    printf("  alert    %3zu B JSON, %d B frame\n", strlen(alert_json), USF_FRAME_V1_SIZE);
+    check(USF_FRAME_V1_SIZE * 2 < strlen(command_json), "a frame is under half the JSON command");
+
+    printf("parse time (host CPU)\n");
+    double frame_ns = frame_view_ns();
+    printf("  frame    %8.2f ns  usf_frame_view() and field reads\n", frame_ns);
+    double command_ns = json_ns(read_json, command_json);
+    double alert_ns = json_ns(read_json, alert_json);
+    double copy_ns = json_ns(read_json_copy, alert_json);
+    printf("  command  %8.2f ns  cJSON_ParseWithLength() in place\n", command_ns);
+    printf("  alert    %8.2f ns  cJSON_ParseWithLength() in place\n", alert_ns);
+    printf("  alert    %8.2f ns  strndup() + cJSON_Parse(), the old HMI path\n", copy_ns);
+    check(command_ns > 0 && alert_ns > 0 && copy_ns > 0, "cJSON parses every message");
+    check(frame_ns * 10 < command_ns, "frame view at least 10x cheaper than the JSON parse");
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
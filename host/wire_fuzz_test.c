@@ -0,0 +1,284 @@
+// wire_fuzz_test.c - usf_wire.h and the HMI's status frame path under random input
+//
+// Built with ASan/UBSan where the compiler has them. Every input sits in an
+// exact-size heap buffer, so reading one byte past a payload is reported.
+// - usf_frame_view() on random and bit-flipped payloads of 0-40 bytes
+// - mqtt_event_handler() -> handle_status_frame() on the same inputs delivered
+//   whole and in random fragments, plus messages too large to reassemble
+// - Round trip, a newer version with appended fields, command names
+// - handle_json_message() through the vendored cJSON on truncated, bit-flipped
+//   and deeply nested JSON, and the JSON send_mqtt() enqueues by default
+// Bytes and parse time against JSON are in wire_bench.c, built without sanitizers.
+
+#include "HMIESP32.C"
+#include "hmi_sim.h"
+
+#include <stdlib.h>
+
+#define FUZZ_VIEW_INPUTS 2000000
+#define FUZZ_HMI_INPUTS 200000
+#define FUZZ_JSON_INPUTS 200000
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("  %-60s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+// xorshift32, so a failure reproduces on every run
+static uint32_t random_state = 1;
+
+static uint32_t next_random(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static usf_frame_t alarm_frame(uint32_t seq) {
+    usf_frame_t frame;
+    usf_frame_init(&frame, USF_MSG_ALARM, seq, 123456);
+    frame.led_pattern = 0x0107;
+    frame.direction = USF_DIR_UP;
+    frame.alarm_level = USF_LEVEL_RED;
+    memcpy(frame.alarm_code, "R10", 3);
+    return frame;
+}
+
+// Random bytes, or a valid frame (possibly cut short) with a few bits flipped
+static uint8_t *fuzz_input(size_t *len) {
+    *len = next_random() % 41;
+    uint8_t *buf = malloc(*len ? *len : 1);
+    if (next_random() & 1) {
+        for (size_t i = 0; i < *len; i++) buf[i] = (uint8_t)next_random();
+    } else {
+        usf_frame_t frame = alarm_frame(next_random());
+        memset(buf, 0, *len);
+        memcpy(buf, &frame, *len < sizeof(frame) ? *len : sizeof(frame));
+        for (int flips = next_random() % 4; flips > 0 && *len; flips--) {
+            buf[next_random() % *len] ^= (uint8_t)(1u << (next_random() % 8));
+        }
+    }
+    return buf;
+}
+
+static void fuzz_view(void) {
+    printf("usf_frame_view(): %d random and bit-flipped payloads\n", FUZZ_VIEW_INPUTS);
+    uint32_t accepted = 0, bad = 0, sink = 0;
+    for (int i = 0; i < FUZZ_VIEW_INPUTS; i++) {
+        size_t len;
+        uint8_t *buf = fuzz_input(&len);
+        const usf_frame_t *frame = usf_frame_view(buf, len);
+        if (frame) {
+            accepted++;
+            if ((const void *)frame != buf || len < USF_FRAME_V1_SIZE || frame->magic != USF_WIRE_MAGIC ||
+                frame->version == 0 || frame->length < USF_FRAME_V1_SIZE || frame->length > len) {
+                bad++;
+            }
+            // Touch every field, including the last byte, as a receiver would
+            sink += frame->seq + frame->uptime_ms + frame->led_pattern + frame->alarm_code[3] + frame->reserved +
+                    usf_command_text(frame->command)[0];
+        }
+        free(buf);
+    }
+    printf("  %lu accepted (sink %lu)\n", (unsigned long)accepted, (unsigned long)sink);
+    check(accepted > 0 && bad == 0, "only complete frames of a known layout are accepted");
+    check(usf_frame_view(NULL, 24) == NULL, "NULL payload rejected");
+}
+
+static void round_trip(void) {
+    printf("round trip\n");
+    usf_frame_t frame = alarm_frame(7);
+    uint8_t wire[40] = {0};
+    memcpy(wire + 1, &frame, sizeof(frame)); // Odd offset, as in an MQTT buffer
+    const usf_frame_t *view = usf_frame_view(wire + 1, sizeof(frame));
+    check(view && view->seq == 7 && view->uptime_ms == 123456 && view->led_pattern == 0x0107 &&
+              view->direction == USF_DIR_UP && memcmp(view->alarm_code, "R10", 4) == 0,
+          "fields read back from an unaligned buffer");
+
+    // Version 2 appends 8 bytes; a version 1 reader still reads the first 24
+    memcpy(wire, &frame, sizeof(frame));
+    wire[1] = 2;
+    wire[3] = 32;
+    check(usf_frame_view(wire, 32) != NULL, "newer version with appended fields accepted");
+    check(usf_frame_view(wire, 31) == NULL, "and rejected when cut short of its own length");
+
+    bool names = usf_command_from_text(usf_command_text(USF_CMD_NONE)) == USF_CMD_NONE;
+    for (uint8_t command = USF_CMD_UP; command <= USF_CMD_STOP; command++) {
+        names = names && usf_command_from_text(usf_command_text(command)) == command;
+    }
+    check(names && usf_command_from_text(NULL) == USF_CMD_NONE && *usf_command_text(9) == '\0',
+          "command names round trip, unknown ones map to none");
+}
+
+static void deliver_frame(const void *data, int len, int chunk) {
+    hmi_sim_mqtt_deliver(USF_BIN_STATUS_TOPIC, data, len, chunk);
+    ui_frame();
+}
+
+static void fuzz_hmi(void) {
+    printf("HMI status frames: %d random inputs, whole and fragmented\n", FUZZ_HMI_INPUTS);
+    for (int i = 0; i < FUZZ_HMI_INPUTS; i++) {
+        size_t len;
+        uint8_t *buf = fuzz_input(&len);
+        int chunk = next_random() & 1 ? 0 : 1 + (int)(next_random() % 8);
+        if (i % 1000 == 0) {
+            // Too large to reassemble: dropped, fragment by fragment
+            free(buf);
+            len = MQTT_RX_BUF_SIZE + 1 + next_random() % 64;
+            buf = malloc(len);
+            memset(buf, 0xA5, len);
+            chunk = 1024;
+        }
+        hmi_sim_mqtt_deliver(USF_BIN_STATUS_TOPIC, buf, (int)len, chunk);
+        free(buf);
+        if (i % 32 == 0) ui_frame();
+    }
+    ui_frame();
+
+    // The handler still works after all of that
+    status_seq = 100;
+    status_frames_lost = 0;
+    usf_frame_t frame = alarm_frame(101);
+    deliver_frame(&frame, sizeof(frame), 0);
+    check(strcmp(hmi_sim_label_text(label_status), "Motor: Moving Up | Lift | R10 (red)") == 0,
+          "valid frame shown on the status label");
+
+    frame = alarm_frame(102);
+    frame.direction = USF_DIR_DOWN;
+    deliver_frame(&frame, sizeof(frame), 1);
+    check(status_seq == 102 && strstr(hmi_sim_label_text(label_status), "Moving Down"),
+          "same frame one byte per event is reassembled");
+
+    frame = alarm_frame(106);
+    memcpy(frame.alarm_code, "R10X", 4);
+    deliver_frame(&frame, sizeof(frame), 0);
+    check(status_frames_lost == 3, "sequence gap of 3 counted");
+    check(strstr(hmi_sim_label_text(label_status), "R10X (red)") != NULL, "unterminated alarm code printed as 4 chars");
+
+    ui_post(UI_MSG_STATUS, SEV_INFO, "unchanged");
+    ui_frame();
+    frame = alarm_frame(107);
+    deliver_frame(&frame, sizeof(frame) - 1, 0);
+    frame.length = sizeof(frame) + 1;
+    deliver_frame(&frame, sizeof(frame), 0);
+    frame = alarm_frame(107);
+    frame.type = USF_MSG_COMMAND;
+    deliver_frame(&frame, sizeof(frame), 0);
+    check(strcmp(hmi_sim_label_text(label_status), "unchanged") == 0 && status_seq == 106,
+          "short, overlong and command frames ignored");
+
+    frame = alarm_frame(107);
+    frame.alarm_level = 7;
+    frame.direction = 9;
+    deliver_frame(&frame, sizeof(frame), 0);
+    check(strcmp(hmi_sim_label_text(label_status), "Motor: ? | Lift | No alarms") == 0,
+          "out-of-range direction and alarm level shown safely");
+}
+
+static const char *json_seeds[] = {
+    "{\"type\":\"red\",\"message\":\"R10 - Final Limit\",\"led_code\":\"1110-0000\",\"timestamp\":\"2026-10-17 12:00:00\"}",
+    "{\"type\":\"command\",\"message\":\"COMMAND:UP\",\"timestamp\":\"2026-10-17T12:00:00\"}",
+    "{ \"type\" : \"info\", \"message\" : \"caf\\u00e9 \\ud83d\\ude00 \\\"q\\\"\", \"timestamp\" : \"t\", \"n\" : [1, -2.5e3, true, null, {}] }",
+};
+
+static const char *last_entry(const log_ring_t *ring) {
+    return ring->total ? ring->entries[(ring->total - 1) % ring->capacity].text : "";
+}
+
+// A seed message cut short, with bytes flipped or JSON punctuation dropped in
+static char *json_input(size_t *len) {
+    const char *seed = json_seeds[next_random() % (sizeof(json_seeds) / sizeof(json_seeds[0]))];
+    size_t seed_len = strlen(seed);
+    *len = next_random() & 3 ? seed_len : next_random() % (seed_len + 1);
+    char *buf = malloc(*len ? *len : 1);
+    memcpy(buf, seed, *len);
+    static const char punctuation[] = "{}[]:,\"\\u0-.e";
+    for (int edits = next_random() % 4; edits > 0 && *len; edits--) {
+        size_t at = next_random() % *len;
+        if (next_random() & 1) {
+            buf[at] ^= (char)(1u << (next_random() % 8));
+        } else {
+            buf[at] = punctuation[next_random() % (sizeof(punctuation) - 1)];
+        }
+    }
+    return buf;
+}
+
+static void fuzz_json(void) {
+    printf("HMI JSON messages: %d mutated inputs, whole and fragmented\n", FUZZ_JSON_INPUTS);
+    for (int i = 0; i < FUZZ_JSON_INPUTS; i++) {
+        size_t len;
+        char *buf = json_input(&len);
+        int chunk = next_random() & 1 ? 0 : 1 + (int)(next_random() % 16);
+        hmi_sim_mqtt_deliver(MQTT_TOPIC, buf, (int)len, chunk);
+        free(buf);
+        if (i % 32 == 0) ui_frame();
+    }
+    ui_frame();
+
+    // Nested past cJSON's limit of 1000, and an unterminated string: rejected without a crash
+    size_t deep = 1500;
+    char *nested = malloc(deep * 2);
+    memset(nested, '[', deep);
+    memset(nested + deep, ']', deep);
+    uint32_t before = log_ring.total;
+    hmi_sim_mqtt_deliver(MQTT_TOPIC, nested, (int)(deep * 2), 0);
+    free(nested);
+    hmi_sim_mqtt_deliver(MQTT_TOPIC, "{\"type\":\"red", 13, 0);
+    ui_frame();
+    check(log_ring.total == before, "deep nesting and an unterminated string ignored");
+
+    hmi_sim_mqtt_deliver(MQTT_TOPIC, json_seeds[0], (int)strlen(json_seeds[0]), 7);
+    ui_frame();
+    check(strcmp(last_entry(&log_ring), "[2026-10-17 12:00:00] ALERT (red): R10 - Final Limit") == 0 &&
+              strcmp(last_entry(&alert_ring), "[2026-10-17 12:00:00] red: R10 - Final Limit") == 0,
+          "valid alert logged and shown on the alert terminal");
+
+    hmi_sim_mqtt_deliver(MQTT_TOPIC, json_seeds[2], (int)strlen(json_seeds[2]), 0);
+    ui_frame();
+    check(strcmp(last_entry(&log_ring), "[t] info: caf\xc3\xa9 \xf0\x9f\x98\x80 \"q\"") == 0,
+          "escapes and surrogate pairs decoded, extra fields skipped");
+}
+
+// The command JSON as the motor's current firmware expects it
+static void send_defaults(void) {
+    printf("send_mqtt() with USF_BINARY_COMMANDS %d\n", USF_BINARY_COMMANDS);
+    check(USF_BINARY_COMMANDS == 0, "binary commands are off by default");
+    mqtt_connected = true;
+    send_mqtt("COMMAND:UP");
+    int general_qos = -1, command_qos = -1;
+    const char *general = hmi_sim_mqtt_last(MQTT_TOPIC, &general_qos);
+    const char *command = hmi_sim_mqtt_last("usf/logs/command", &command_qos);
+    check(hmi_sim_mqtt_enqueued(MQTT_TOPIC) == 1 && hmi_sim_mqtt_enqueued("usf/logs/command") == 1 &&
+              hmi_sim_mqtt_enqueued(USF_BIN_COMMAND_TOPIC) == 0,
+          "one JSON message each on usf/messages and usf/logs/command");
+    check(general_qos == 1 && command_qos == 1, "both at QoS 1");
+
+    cJSON *root = command ? cJSON_Parse(command) : NULL;
+    cJSON *type = cJSON_GetObjectItem(root, "type");
+    cJSON *message = cJSON_GetObjectItem(root, "message");
+    check(general && command && strcmp(general, command) == 0 && cJSON_IsString(type) &&
+              strcmp(type->valuestring, "command") == 0 && cJSON_IsString(message) &&
+              strcmp(message->valuestring, "COMMAND:UP") == 0 &&
+              cJSON_IsString(cJSON_GetObjectItem(root, "timestamp")),
+          "payload is {type: command, message, timestamp}");
+    cJSON_Delete(root);
+}
+
+int main(void) {
+    ui_queue = xQueueCreate(UI_QUEUE_LEN, sizeof(ui_msg_t));
+    log_ring_init(&log_ring, LOG_RING_ENTRIES);
+    log_ring_init(&alert_ring, ALERT_RING_ENTRIES);
+    ui_init();
+    mqtt_start();
+
+    fuzz_view();
+    round_trip();
+    fuzz_hmi();
+    fuzz_json();
+    send_defaults();
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
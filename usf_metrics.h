@@ -0,0 +1,114 @@
+// usf_metrics.h - Fixed-bucket latency histograms shared by the Motor (Arduino C++) and HMI (ESP-IDF C) firmware
+//
+// Cheap enough to leave on in production: an observation is a bucket index from
+// the bit length of the duration plus two 64-bit adds inside a sequence counter.
+// No locks, heap or floats.
+// - Each histogram has exactly one writer task; any task may read it. The 64-bit
+//   fields cannot be stored in one instruction on a 32-bit core, so readers retry
+//   while the sequence counter says a write is under way (a seqlock)
+// - Buckets grow by 4x: <=16 us, <=64 us, ... <=4.19 s, then one overflow bucket
+// - Pure C with no platform headers; callers pass durations in microseconds
+
+#ifndef USF_METRICS_H
+#define USF_METRICS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ===== Topic =====
+#define USF_METRICS_TOPIC "usf/metrics" // Compact JSON snapshot from each device, "dev" tells them apart
+
+// ===== Histogram =====
+#define USF_HIST_BOUNDS  10                   // Finite buckets
+#define USF_HIST_BUCKETS (USF_HIST_BOUNDS + 1) // Plus the overflow bucket
+
+#define USF_HIST_READ_TRIES 64 // A reader that preempted the writer on its own core gives up after this
+
+typedef struct {
+    uint32_t seq;                       // Odd while the writer is updating the fields below
+    uint64_t buckets[USF_HIST_BUCKETS]; // Observations per bucket (not cumulative)
+    uint64_t sum_us;
+} usf_hist_t;
+
+// Upper bound of a finite bucket in microseconds
+static inline uint32_t usf_hist_bound_us(int bucket) {
+    return 16u << (2 * bucket);
+}
+
+// Bucket of a duration: 2 bits of bit length per bucket, no search
+static inline int usf_hist_bucket(uint32_t us) {
+    if (us <= 16) return 0;
+    int bucket = (33 - __builtin_clz(us - 1)) / 2 - 2;
+    return bucket < USF_HIST_BOUNDS ? bucket : USF_HIST_BOUNDS;
+}
+
+// Writer task only
+static inline void usf_hist_observe(usf_hist_t *hist, uint32_t us) {
+    uint32_t seq = hist->seq;
+    __atomic_store_n(&hist->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    hist->buckets[usf_hist_bucket(us)]++;
+    hist->sum_us += us;
+    __atomic_store_n(&hist->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// Copy a histogram from any task. Returns 0 (and leaves *out unusable) if no
+// consistent copy was seen in USF_HIST_READ_TRIES attempts.
+static inline int usf_hist_read(const usf_hist_t *hist, usf_hist_t *out) {
+    for (int tries = 0; tries < USF_HIST_READ_TRIES; tries++) {
+        uint32_t seq = __atomic_load_n(&hist->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) continue;
+        for (int i = 0; i < USF_HIST_BUCKETS; i++) out->buckets[i] = hist->buckets[i];
+        out->sum_us = hist->sum_us;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&hist->seq, __ATOMIC_RELAXED) == seq) {
+            out->seq = seq;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static inline uint64_t usf_hist_count(const usf_hist_t *hist) {
+    uint64_t count = 0;
+    for (int i = 0; i < USF_HIST_BUCKETS; i++) count += hist->buckets[i];
+    return count;
+}
+
+// Observations since *last and the bucket bounds (us) that 50% and 99% of them
+// fell under; the overflow bucket reports twice the last bound. *last is updated.
+// If no consistent copy could be read, reports nothing and the next call catches up.
+static inline uint32_t usf_hist_interval(const usf_hist_t *hist, usf_hist_t *last, uint32_t *p50_us, uint32_t *p99_us) {
+    usf_hist_t now;
+    uint64_t delta[USF_HIST_BUCKETS];
+    uint64_t count = 0;
+    *p50_us = 0;
+    *p99_us = 0;
+    if (!usf_hist_read(hist, &now)) return 0;
+    for (int i = 0; i < USF_HIST_BUCKETS; i++) {
+        delta[i] = now.buckets[i] - last->buckets[i];
+        count += delta[i];
+    }
+    *last = now;
+    if (count == 0) return 0;
+    uint64_t seen = 0;
+    for (int i = 0; i < USF_HIST_BUCKETS; i++) {
+        uint32_t bound = i < USF_HIST_BOUNDS ? usf_hist_bound_us(i) : 2 * usf_hist_bound_us(USF_HIST_BOUNDS - 1);
+        seen += delta[i];
+        if (*p50_us == 0 && seen * 100 >= count * 50) *p50_us = bound;
+        if (seen * 100 >= count * 99) {
+            *p99_us = bound;
+            break;
+        }
+    }
+    return (uint32_t)count;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // USF_METRICS_H
@@ -0,0 +1,103 @@
+// usf_wire.h - Compact binary frames shared by the Motor (Arduino C++) and HMI (ESP-IDF C) firmware
+//
+// JSON stays on usf/messages and usf/logs/... for the web dashboard. The same
+// state and commands are also exchanged as fixed 24-byte frames on usf/bin/...
+// - Frames are packed little-endian structs, read in place from the MQTT buffer
+// - Newer versions may only append fields; receivers read the fields they know
+// - Pure C with no platform headers, so it also builds on a Linux host
+
+#ifndef USF_WIRE_H
+#define USF_WIRE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ===== Topics =====
+#define USF_BIN_STATUS_TOPIC  "usf/bin/status"  // Motor -> HMI: USF_MSG_STATUS / USF_MSG_ALARM
+#define USF_BIN_COMMAND_TOPIC "usf/bin/command" // HMI -> Motor: USF_MSG_COMMAND
+
+// ===== Frame Header Values =====
+#define USF_WIRE_MAGIC   0xA5
+#define USF_WIRE_VERSION 1
+
+enum { USF_MSG_STATUS = 1, USF_MSG_ALARM = 2, USF_MSG_COMMAND = 3 };
+enum { USF_DIR_STOP = 0, USF_DIR_UP = 1, USF_DIR_DOWN = 2 };
+enum { USF_MODE_LIFT = 0, USF_MODE_ELEVATOR = 1 };
+enum { USF_LEVEL_NONE = 0, USF_LEVEL_GREEN = 1, USF_LEVEL_AMBER = 2, USF_LEVEL_RED = 3 };
+enum { USF_CMD_NONE = 0, USF_CMD_UP = 1, USF_CMD_DOWN = 2, USF_CMD_STOP = 3 };
+
+// ===== Frame Layout (version 1) =====
+typedef struct __attribute__((packed)) {
+    uint8_t magic;        // USF_WIRE_MAGIC
+    uint8_t version;      // USF_WIRE_VERSION of the sender
+    uint8_t type;         // USF_MSG_*
+    uint8_t length;       // Frame size of the sender's version
+    uint32_t seq;         // Per-sender sequence number, gaps mean lost frames
+    uint32_t uptime_ms;   // Sender's monotonic clock (not wall time)
+    uint16_t led_pattern; // Motor LED bitmask: red, green, red flashing, green flashing nibbles
+    uint8_t direction;    // USF_DIR_*
+    uint8_t mode;         // USF_MODE_*
+    uint8_t alarm_level;  // USF_LEVEL_* of alarm_code
+    uint8_t command;      // USF_CMD_* (command frames only)
+    char alarm_code[4];   // Most severe active alarm ("R01", "A38", ...), NUL padded, not always terminated
+    uint16_t reserved;    // Zero
+} usf_frame_t;
+
+#define USF_FRAME_V1_SIZE 24
+
+#ifdef __cplusplus
+static_assert(sizeof(usf_frame_t) == USF_FRAME_V1_SIZE, "usf_frame_t layout changed");
+#else
+_Static_assert(sizeof(usf_frame_t) == USF_FRAME_V1_SIZE, "usf_frame_t layout changed");
+#endif
+
+// Start a frame of the given type; all other fields are zero
+static inline void usf_frame_init(usf_frame_t *frame, uint8_t type, uint32_t seq, uint32_t uptime_ms) {
+    memset(frame, 0, sizeof(*frame));
+    frame->magic = USF_WIRE_MAGIC;
+    frame->version = USF_WIRE_VERSION;
+    frame->type = type;
+    frame->length = sizeof(*frame);
+    frame->seq = seq;
+    frame->uptime_ms = uptime_ms;
+}
+
+// View a received payload as a frame without copying it.
+// Returns NULL if it is not a frame this firmware can read.
+static inline const usf_frame_t *usf_frame_view(const void *payload, size_t len) {
+    const usf_frame_t *frame = (const usf_frame_t *)payload;
+    if (!payload || len < USF_FRAME_V1_SIZE) return NULL;
+    if (frame->magic != USF_WIRE_MAGIC || frame->version == 0) return NULL;
+    if (frame->length < USF_FRAME_V1_SIZE || frame->length > len) return NULL;
+    return frame;
+}
+
+// ===== Command Names =====
+// Text form used by the JSON "message" field, e.g. {"type":"command","message":"COMMAND:UP"}
+static inline const char *usf_command_text(uint8_t command) {
+    switch (command) {
+        case USF_CMD_UP: return "COMMAND:UP";
+        case USF_CMD_DOWN: return "COMMAND:DOWN";
+        case USF_CMD_STOP: return "COMMAND:STOP";
+        default: return "";
+    }
+}
+
+static inline uint8_t usf_command_from_text(const char *text) {
+    if (!text) return USF_CMD_NONE;
+    if (strcmp(text, "COMMAND:UP") == 0) return USF_CMD_UP;
+    if (strcmp(text, "COMMAND:DOWN") == 0) return USF_CMD_DOWN;
+    if (strcmp(text, "COMMAND:STOP") == 0) return USF_CMD_STOP;
+    return USF_CMD_NONE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // USF_WIRE_H